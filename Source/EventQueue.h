@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed-capacity queue of events stamped with an absolute sample time.
+//
+// Events come out earliest first, and in the order they were pushed where
+// their times are equal. Storage is a binary heap inside the object, so
+// pushing and popping never allocate and are safe on the audio thread.
+template <typename Payload, int capacity>
+class EventQueue
+{
+public:
+    struct Event
+    {
+        int64_t time = 0;
+        Payload payload {};
+    };
+
+    void clear()
+    {
+        size = 0;
+        nextOrder = 0;
+    }
+
+    bool isEmpty() const { return size == 0; }
+    int getNumEvents() const { return size; }
+
+    // Time of the earliest event; the queue must not be empty.
+    int64_t nextTime() const { return heap[0].time; }
+
+    // Returns false, dropping the event, when the queue is full.
+    bool push(int64_t time, const Payload& payload)
+    {
+        if (size >= capacity)
+            return false;
+
+        const Node node { time, nextOrder++, payload };
+        int i = size++;
+
+        while (i > 0)
+        {
+            const int parent = (i - 1) / 2;
+            if (!isEarlier(node, heap[static_cast<size_t>(parent)]))
+                break;
+
+            heap[static_cast<size_t>(i)] = heap[static_cast<size_t>(parent)];
+            i = parent;
+        }
+
+        heap[static_cast<size_t>(i)] = node;
+        return true;
+    }
+
+    // Removes and returns the earliest event; the queue must not be empty.
+    Event pop()
+    {
+        const Event event { heap[0].time, heap[0].payload };
+        const Node last = heap[static_cast<size_t>(--size)];
+        int i = 0;
+
+        for (;;)
+        {
+            int child = 2 * i + 1;
+            if (child >= size)
+                break;
+
+            if (child + 1 < size && isEarlier(heap[static_cast<size_t>(child + 1)], heap[static_cast<size_t>(child)]))
+                ++child;
+
+            if (!isEarlier(heap[static_cast<size_t>(child)], last))
+                break;
+
+            heap[static_cast<size_t>(i)] = heap[static_cast<size_t>(child)];
+            i = child;
+        }
+
+        heap[static_cast<size_t>(i)] = last;
+        return event;
+    }
+
+private:
+    struct Node
+    {
+        int64_t time = 0;
+        uint64_t order = 0;
+        Payload payload {};
+    };
+
+    static bool isEarlier(const Node& a, const Node& b)
+    {
+        return a.time < b.time || (a.time == b.time && a.order < b.order);
+    }
+
+    std::array<Node, static_cast<size_t>(capacity)> heap {};
+    int size = 0;
+    uint64_t nextOrder = 0;
+};
@@ -0,0 +1,181 @@
+#include "HitCache.h"
+
+#include <algorithm>
+
+void HitCache::prepare(size_t maxBytes, int maxHitSamples, int maxEntries)
+{
+    const size_t numPages = maxBytes / (sizeof(float) * static_cast<size_t>(pageSamples));
+
+    arena.assign(numPages * static_cast<size_t>(pageSamples), 0.0f);
+    freePages.reserve(numPages);
+    maxPagesPerEntry = (maxHitSamples + pageSamples - 1) / pageSamples;
+    entries.assign(static_cast<size_t>(maxEntries), {});
+    entryPages.assign(static_cast<size_t>(maxEntries) * static_cast<size_t>(maxPagesPerEntry), -1);
+
+    clear();
+}
+
+void HitCache::clear()
+{
+    for (auto& entry : entries)
+        entry = {};
+
+    freePages.clear();
+    const int numPages = static_cast<int>(arena.size() / static_cast<size_t>(pageSamples));
+    for (int page = numPages; --page >= 0;)
+        freePages.push_back(page);
+
+    useCounter = 0;
+}
+
+int HitCache::acquire(const Key& key)
+{
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        auto& entry = entries[i];
+        if (entry.state == State::ready && entry.key == key)
+        {
+            ++entry.users;
+            entry.lastUsed = ++useCounter;
+            return static_cast<int>(i);
+        }
+    }
+
+    return -1;
+}
+
+bool HitCache::isRecording(const Key& key) const
+{
+    return std::any_of(entries.begin(), entries.end(), [&key](const Entry& entry)
+    {
+        return entry.state == State::recording && entry.key == key;
+    });
+}
+
+int HitCache::beginRecording(const Key& key, int lengthSamples)
+{
+    const int numPages = (lengthSamples + pageSamples - 1) / pageSamples;
+    if (lengthSamples <= 0 || numPages > maxPagesPerEntry)
+        return -1;
+
+    auto findFreeEntry = [this]
+    {
+        for (size_t i = 0; i < entries.size(); ++i)
+            if (entries[i].state == State::free)
+                return static_cast<int>(i);
+
+        return -1;
+    };
+
+    // Only evict when that will make room: a hit longer than the pages free
+    // plus those of idle entries, up to a hit larger than the whole arena,
+    // would otherwise flush the cache and still not fit.
+    int reclaimablePages = static_cast<int>(freePages.size());
+    for (const auto& entry : entries)
+        if (entry.state == State::ready && entry.users == 0)
+            reclaimablePages += entry.numPages;
+
+    if (numPages > reclaimablePages)
+        return -1;
+
+    int slot = findFreeEntry();
+    while (slot < 0 || static_cast<int>(freePages.size()) < numPages)
+    {
+        if (!evictLeastRecentlyUsed())
+            return -1;
+
+        if (slot < 0)
+            slot = findFreeEntry();
+    }
+
+    auto& entry = entries[static_cast<size_t>(slot)];
+    entry.key = key;
+    entry.state = State::recording;
+    entry.length = lengthSamples;
+    entry.numPages = numPages;
+    entry.users = 1;
+    entry.lastUsed = ++useCounter;
+
+    auto* pages = pagesOf(slot);
+    for (int i = 0; i < numPages; ++i)
+    {
+        pages[i] = freePages.back();
+        freePages.pop_back();
+        std::fill_n(arena.data() + static_cast<size_t>(pages[i]) * static_cast<size_t>(pageSamples), pageSamples, 0.0f);
+    }
+
+    return slot;
+}
+
+void HitCache::finishRecording(int entry)
+{
+    auto& e = entries[static_cast<size_t>(entry)];
+    if (e.state == State::recording)
+        e.state = State::ready;
+}
+
+void HitCache::release(int entry)
+{
+    auto& e = entries[static_cast<size_t>(entry)];
+    e.users = std::max(0, e.users - 1);
+
+    if (e.state == State::recording || (e.state == State::stale && e.users == 0))
+        freeEntry(entry);
+}
+
+void HitCache::invalidateDrum(int drum)
+{
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        auto& entry = entries[i];
+        if (entry.state == State::free || entry.key.drum != drum)
+            continue;
+
+        if (entry.users == 0)
+            freeEntry(static_cast<int>(i));
+        else
+            entry.state = State::stale;
+    }
+}
+
+float* HitCache::getPointer(int entry, int position, int& numAvailable)
+{
+    const auto& e = entries[static_cast<size_t>(entry)];
+    const int page = pagesOf(entry)[position / pageSamples];
+    const int offset = position % pageSamples;
+
+    numAvailable = std::min(pageSamples - offset, e.length - position);
+    return arena.data() + static_cast<size_t>(page) * static_cast<size_t>(pageSamples) + static_cast<size_t>(offset);
+}
+
+void HitCache::freeEntry(int entry)
+{
+    auto& e = entries[static_cast<size_t>(entry)];
+    const auto* pages = pagesOf(entry);
+
+    for (int i = 0; i < e.numPages; ++i)
+        freePages.push_back(pages[i]);
+
+    e = {};
+}
+
+bool HitCache::evictLeastRecentlyUsed()
+{
+    int oldest = -1;
+
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const auto& entry = entries[i];
+        if (entry.state != State::ready || entry.users > 0)
+            continue;
+
+        if (oldest < 0 || entry.lastUsed < entries[static_cast<size_t>(oldest)].lastUsed)
+            oldest = static_cast<int>(i);
+    }
+
+    if (oldest < 0)
+        return false;
+
+    freeEntry(oldest);
+    return true;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fixed-size store of pre-rendered drum hits, so a hit that repeats with the
+// same key can be mixed back instead of synthesised again.
+//
+// All memory is allocated in prepare(); the audio thread only hands out and
+// reclaims pages. Audio is held in pages so that entries of any length share
+// one arena without fragmenting it. Entries are reference counted by the
+// voices using them and evicted least-recently-used first.
+class HitCache
+{
+public:
+    struct Key
+    {
+        int drum = -1;
+        int velocityStep = 0;
+        int variant = 0;
+
+        bool operator==(const Key& other) const
+        {
+            return drum == other.drum && velocityStep == other.velocityStep && variant == other.variant;
+        }
+    };
+
+    static constexpr int pageSamples = 4096;
+
+    // Sizes the arena to at most maxBytes and entries to maxHitSamples.
+    void prepare(size_t maxBytes, int maxHitSamples, int maxEntries);
+    void clear();
+
+    // A complete entry for key, acquired for one voice, or -1.
+    int acquire(const Key& key);
+
+    // True while an entry for key is still being recorded.
+    bool isRecording(const Key& key) const;
+
+    // Reserves a zeroed entry of lengthSamples for one voice to record into,
+    // evicting unused entries as needed. Returns -1 if it does not fit.
+    int beginRecording(const Key& key, int lengthSamples);
+    void finishRecording(int entry);
+
+    // Drops a voice's hold on an entry; unfinished recordings are discarded.
+    void release(int entry);
+
+    // Marks every entry of a drum out of date. Entries still in use stay
+    // readable until released, but are never handed out again.
+    void invalidateDrum(int drum);
+
+    bool isValid(int entry) const { return entries[static_cast<size_t>(entry)].state != State::stale; }
+    int getLength(int entry) const { return entries[static_cast<size_t>(entry)].length; }
+
+    // Contiguous run of an entry's audio starting at position; numAvailable
+    // is set to how many samples may be accessed through the pointer.
+    float* getPointer(int entry, int position, int& numAvailable);
+
+private:
+    enum class State
+    {
+        free,
+        recording,
+        ready,
+        stale
+    };
+
+    struct Entry
+    {
+        Key key;
+        State state = State::free;
+        int length = 0;
+        int numPages = 0;
+        int users = 0;
+        uint64_t lastUsed = 0;
+    };
+
+    int* pagesOf(int entry) { return entryPages.data() + static_cast<size_t>(entry) * static_cast<size_t>(maxPagesPerEntry); }
+    void freeEntry(int entry);
+    bool evictLeastRecentlyUsed();
+
+    std::vector<float> arena;
+    std::vector<int> freePages;
+    std::vector<Entry> entries;
+    std::vector<int> entryPages;
+    int maxPagesPerEntry = 0;
+    uint64_t useCounter = 0;
+};
@@ -26,6 +26,20 @@ constexpr std::array<BurialDrumPluginAudioProcessor::DrumType, 8> drumTypes {
     BurialDrumPluginAudioProcessor::DrumType::rim
 };
 
+constexpr int sequencerPanelHeight = 200;
+constexpr int gridNameWidth = 84;
+constexpr float softStepVelocity = 0.7f;
+
+// Chain patterns are shown 1-based, as the pattern box numbers them.
+juce::String chainToText(const juce::Array<int>& chain)
+{
+    juce::StringArray text;
+    for (const int pattern : chain)
+        text.add(juce::String(pattern + 1));
+
+    return text.joinIntoString(" ");
+}
+
 struct PresetData
 {
     const char* name = "";
@@ -73,7 +87,7 @@ BurialDrumPluginAudioProcessorEditor::BurialDrumPluginAudioProcessorEditor(Buria
     : AudioProcessorEditor(&p), audioProcessor(p)
 {
     setLookAndFeel(&retroLookAndFeel);
-    setSize(1040, 640);
+    setSize(1040, 848);
 
     presetLabel.setText("PRESET", juce::dontSendNotification);
     presetLabel.setColour(juce::Label::textColourId, uiPhosphor);
@@ -110,9 +124,17 @@ BurialDrumPluginAudioProcessorEditor::BurialDrumPluginAudioProcessorEditor(Buria
     testSequenceButton.setColour(juce::TextButton::buttonOnColourId, uiPanel);
     testSequenceButton.setColour(juce::TextButton::textColourOffId, uiPhosphor);
     testSequenceButton.setColour(juce::TextButton::textColourOnId, uiPhosphor);
-    testSequenceButton.onClick = [this] { audioProcessor.startTestSequence(); };
+    testSequenceButton.onClick = [this] { audioProcessor.startSequencer(loopButton.getToggleState()); };
     addAndMakeVisible(testSequenceButton);
 
+    stopSequenceButton.setButtonText("STOP");
+    stopSequenceButton.setColour(juce::TextButton::buttonColourId, uiPanel);
+    stopSequenceButton.setColour(juce::TextButton::buttonOnColourId, uiPanel);
+    stopSequenceButton.setColour(juce::TextButton::textColourOffId, uiPhosphor);
+    stopSequenceButton.setColour(juce::TextButton::textColourOnId, uiPhosphor);
+    stopSequenceButton.onClick = [this] { audioProcessor.stopSequencer(); };
+    addAndMakeVisible(stopSequenceButton);
+
     infoLabel.setJustificationType(juce::Justification::topLeft);
     infoLabel.setFont(juce::Font(juce::FontOptions(12.0f)));
     infoLabel.setColour(juce::Label::textColourId, uiPhosphorDim);
@@ -121,6 +143,11 @@ BurialDrumPluginAudioProcessorEditor::BurialDrumPluginAudioProcessorEditor(Buria
         juce::dontSendNotification);
     addAndMakeVisible(infoLabel);
 
+    partialsLabel.setJustificationType(juce::Justification::bottomLeft);
+    partialsLabel.setFont(juce::Font(juce::FontOptions(12.0f)));
+    partialsLabel.setColour(juce::Label::textColourId, uiPhosphorDim);
+    addAndMakeVisible(partialsLabel);
+
     configureSlider(tuneSlider, tuneLabel, "Tune");
     configureSlider(decaySlider, decayLabel, "Decay");
     configureSlider(toneSlider, toneLabel, "Tone");
@@ -165,7 +192,73 @@ BurialDrumPluginAudioProcessorEditor::BurialDrumPluginAudioProcessorEditor(Buria
         drumDriveAttachments[i] = std::make_unique<SliderAttachment>(apvts, prefix + "Drive", drumDriveSliders[i]);
     }
 
-    presetBox.setSelectedId(1, juce::sendNotificationSync);
+    configureSequencerLabel(patternLabel, "Pattern");
+    configureSequencerLabel(lengthLabel, "Length");
+    configureSequencerLabel(pageLabel, "Steps");
+    configureSequencerLabel(chainLabel, "Chain");
+
+    for (auto* box : { &patternBox, &lengthBox, &pageBox })
+    {
+        box->setColour(juce::ComboBox::backgroundColourId, uiPanel);
+        box->setColour(juce::ComboBox::textColourId, uiPhosphor);
+        box->setColour(juce::ComboBox::outlineColourId, uiPhosphorDim);
+        box->setColour(juce::ComboBox::arrowColourId, uiPhosphor);
+        addAndMakeVisible(box);
+    }
+
+    for (int pattern = 1; pattern <= StepSequencer::maxPatterns; ++pattern)
+        patternBox.addItem(juce::String(pattern), pattern);
+    patternBox.setSelectedId(1, juce::dontSendNotification);
+    patternBox.onChange = [this]
+    {
+        stepGrid.pattern = juce::jmax(0, patternBox.getSelectedId() - 1);
+        refreshSequencer();
+    };
+
+    for (int steps = 16; steps <= StepSequencer::maxSteps; steps += 16)
+        lengthBox.addItem(juce::String(steps), steps);
+    lengthBox.onChange = [this]
+    {
+        if (const int steps = lengthBox.getSelectedId(); steps > 0)
+            audioProcessor.setSequencerPatternLength(stepGrid.pattern, steps);
+    };
+
+    for (int page = 0; page < StepSequencer::maxSteps / stepsPerPage; ++page)
+        pageBox.addItem(juce::String(page * stepsPerPage + 1) + "-" + juce::String((page + 1) * stepsPerPage), page + 1);
+    pageBox.setSelectedId(1, juce::dontSendNotification);
+    pageBox.onChange = [this]
+    {
+        stepGrid.page = juce::jmax(0, pageBox.getSelectedId() - 1);
+        stepGrid.repaint();
+    };
+
+    chainEditor.setColour(juce::TextEditor::backgroundColourId, uiPanel);
+    chainEditor.setColour(juce::TextEditor::textColourId, uiPhosphor);
+    chainEditor.setColour(juce::TextEditor::outlineColourId, uiPhosphorDim);
+    chainEditor.setColour(juce::TextEditor::focusedOutlineColourId, uiPhosphor);
+    chainEditor.setFont(juce::Font(juce::FontOptions(12.0f)));
+    chainEditor.setInputRestrictions(3 * StepSequencer::maxChainLength, "0123456789 ");
+    chainEditor.onReturnKey = [this] { applySequencerChain(); };
+    chainEditor.onFocusLost = [this] { applySequencerChain(); };
+    addAndMakeVisible(chainEditor);
+
+    for (auto* button : { &loopButton, &followHostButton })
+    {
+        button->setColour(juce::ToggleButton::textColourId, uiPhosphor);
+        button->setColour(juce::ToggleButton::tickColourId, uiPhosphor);
+        button->setColour(juce::ToggleButton::tickDisabledColourId, uiPhosphorDim);
+        addAndMakeVisible(button);
+    }
+
+    followHostAttachment = std::make_unique<ButtonAttachment>(apvts, "sequencerFollow", followHostButton);
+    addAndMakeVisible(stepGrid);
+
+    // Opening the editor shows the first preset without loading it over the
+    // current settings.
+    presetBox.setSelectedId(1, juce::dontSendNotification);
+
+    timerCallback();
+    startTimerHz(10);
 }
 
 BurialDrumPluginAudioProcessorEditor::~BurialDrumPluginAudioProcessorEditor()
@@ -228,6 +321,8 @@ void BurialDrumPluginAudioProcessorEditor::applyPreset(int presetIndex)
         setParameterValue(prefix + "Tone", preset.tone[i]);
         setParameterValue(prefix + "Drive", preset.drive[i]);
     }
+
+    audioProcessor.notifyPresetLoaded();
 }
 
 void BurialDrumPluginAudioProcessorEditor::stepPreset(int delta)
@@ -241,6 +336,116 @@ void BurialDrumPluginAudioProcessorEditor::stepPreset(int delta)
     presetBox.setSelectedId(current + 1, juce::sendNotificationSync);
 }
 
+void BurialDrumPluginAudioProcessorEditor::configureSequencerLabel(juce::Label& label, const juce::String& text)
+{
+    label.setText(text.toUpperCase(), juce::dontSendNotification);
+    label.setJustificationType(juce::Justification::centredRight);
+    label.setColour(juce::Label::textColourId, uiPhosphor);
+    label.setFont(juce::Font(juce::FontOptions(12.0f).withStyle("Bold")));
+    addAndMakeVisible(label);
+}
+
+void BurialDrumPluginAudioProcessorEditor::applySequencerChain()
+{
+    auto tokens = juce::StringArray::fromTokens(chainEditor.getText(), " ", "");
+    tokens.removeEmptyStrings();
+
+    std::vector<int> chain;
+    for (const auto& token : tokens)
+        chain.push_back(token.getIntValue() - 1);
+
+    // A chain the sequencer can't play puts back the one it is playing.
+    if (chain.empty() || !audioProcessor.setSequencerChain(chain.data(), static_cast<int>(chain.size())))
+        chainEditor.setText(chainToText(audioProcessor.getSequencerChain()), false);
+}
+
+void BurialDrumPluginAudioProcessorEditor::refreshSequencer()
+{
+    const int length = audioProcessor.getSequencerPatternLength(stepGrid.pattern);
+    if (length % 16 == 0)
+        lengthBox.setSelectedId(length, juce::dontSendNotification);
+    else
+        lengthBox.setText(juce::String(length), juce::dontSendNotification);
+
+    if (!chainEditor.hasKeyboardFocus(false))
+        chainEditor.setText(chainToText(audioProcessor.getSequencerChain()), false);
+
+    stepGrid.repaint();
+}
+
+void BurialDrumPluginAudioProcessorEditor::timerCallback()
+{
+    // Partials above the host's band are culled rather than computed.
+    partialsLabel.setText("Partials: " + juce::String(audioProcessor.getSoundingPartialCount()) + " sounding, "
+                              + juce::String(audioProcessor.getCulledPartialCount()) + " culled",
+                          juce::dontSendNotification);
+
+    // The sequencer bank also changes when the host restores a state.
+    if (const int changes = audioProcessor.getSequencerChangeCount(); changes != shownSequencerChanges)
+    {
+        shownSequencerChanges = changes;
+        refreshSequencer();
+    }
+}
+
+void BurialDrumPluginAudioProcessorEditor::StepGrid::paint(juce::Graphics& g)
+{
+    const int length = processor.getSequencerPatternLength(pattern);
+    const int rowHeight = getHeight() / drumCount;
+    const int cellWidth = (getWidth() - gridNameWidth) / stepsPerPage;
+
+    g.setFont(juce::Font(juce::FontOptions(11.0f).withStyle("Bold")));
+
+    for (size_t row = 0; row < drumCount; ++row)
+    {
+        const int y = static_cast<int>(row) * rowHeight;
+        g.setColour(uiPhosphorDim);
+        g.drawText(juce::String(drumNames[row]).toUpperCase(), 0, y, gridNameWidth - 6, rowHeight, juce::Justification::centredLeft, false);
+
+        for (int column = 0; column < stepsPerPage; ++column)
+        {
+            const int step = page * stepsPerPage + column;
+            const auto cell = juce::Rectangle<int>(gridNameWidth + column * cellWidth, y, cellWidth, rowHeight).reduced(2);
+
+            // Steps past the end of the pattern are only outlined; each beat
+            // starts a shade brighter than the 16ths after it.
+            if (step >= length)
+            {
+                g.setColour(uiPhosphorDim.withAlpha(0.25f));
+                g.drawRect(cell, 1);
+                continue;
+            }
+
+            const float velocity = processor.getSequencerStep(pattern, step, drumTypes[row]);
+            g.setColour(velocity > 0.0f ? uiPhosphor.withAlpha(0.3f + 0.7f * velocity)
+                                        : uiPanel.brighter(step % StepSequencer::stepsPerBeat == 0 ? 0.12f : 0.04f));
+            g.fillRect(cell);
+            g.setColour(uiPhosphorDim);
+            g.drawRect(cell, 1);
+        }
+    }
+}
+
+void BurialDrumPluginAudioProcessorEditor::StepGrid::mouseDown(const juce::MouseEvent& event)
+{
+    const int rowHeight = getHeight() / drumCount;
+    const int cellWidth = (getWidth() - gridNameWidth) / stepsPerPage;
+    if (event.x < gridNameWidth || rowHeight <= 0 || cellWidth <= 0)
+        return;
+
+    const int row = event.y / rowHeight;
+    const int column = (event.x - gridNameWidth) / cellWidth;
+    const int step = page * stepsPerPage + column;
+    if (!juce::isPositiveAndBelow(row, drumCount) || column >= stepsPerPage || step >= processor.getSequencerPatternLength(pattern))
+        return;
+
+    // Off, then soft, then accented, then off again.
+    const auto type = drumTypes[static_cast<size_t>(row)];
+    const float velocity = processor.getSequencerStep(pattern, step, type);
+    processor.setSequencerStep(pattern, step, type, velocity <= 0.0f ? softStepVelocity : (velocity < 1.0f ? 1.0f : 0.0f));
+    repaint();
+}
+
 void BurialDrumPluginAudioProcessorEditor::paint(juce::Graphics& g)
 {
     g.fillAll(uiBg);
@@ -276,6 +481,17 @@ void BurialDrumPluginAudioProcessorEditor::paint(juce::Graphics& g)
 
     area.removeFromTop(8);
 
+    auto sequencerPanel = area.removeFromBottom(sequencerPanelHeight);
+    area.removeFromBottom(8);
+    g.setColour(uiPanel.brighter(0.03f));
+    g.fillRect(sequencerPanel);
+    g.setColour(uiPhosphorDim);
+    g.drawRect(sequencerPanel, 1);
+
+    g.setColour(uiPhosphor);
+    g.setFont(juce::Font(juce::FontOptions(15.0f).withStyle("Bold")));
+    g.drawText("SEQUENCER", sequencerPanel.removeFromTop(28).withTrimmedLeft(10), juce::Justification::centredLeft, false);
+
     auto drumsArea = area;
     const int cardGap = 8;
     const int cardWidth = (drumsArea.getWidth() - (cardGap * 3)) / 4;
@@ -305,7 +521,7 @@ void BurialDrumPluginAudioProcessorEditor::resized()
     auto bounds = getLocalBounds().reduced(12);
 
     auto topBar = bounds.removeFromTop(58);
-    auto controls = topBar.removeFromRight(382);
+    auto controls = topBar.removeFromRight(526);
     controls = controls.withTrimmedTop(3).withTrimmedBottom(3);
     presetLabel.setBounds(controls.removeFromLeft(50));
     controls.removeFromLeft(4);
@@ -315,7 +531,9 @@ void BurialDrumPluginAudioProcessorEditor::resized()
     controls.removeFromLeft(6);
     nextPresetButton.setBounds(controls.removeFromLeft(56));
     controls.removeFromLeft(10);
-    testSequenceButton.setBounds(controls.removeFromLeft(110));
+    testSequenceButton.setBounds(controls.removeFromLeft(60));
+    controls.removeFromLeft(4);
+    stopSequenceButton.setBounds(controls.removeFromLeft(60));
 
     auto globalArea = bounds.removeFromTop(144);
     globalArea.removeFromTop(24);
@@ -334,10 +552,38 @@ void BurialDrumPluginAudioProcessorEditor::resized()
         globalKnobs.removeFromLeft(globalGap);
     }
 
-    infoLabel.setBounds(globalArea.reduced(10, 10));
+    auto infoArea = globalArea.reduced(10, 10);
+    partialsLabel.setBounds(infoArea.removeFromBottom(18));
+    infoLabel.setBounds(infoArea);
 
     bounds.removeFromTop(8);
 
+    auto sequencerArea = bounds.removeFromBottom(sequencerPanelHeight);
+    bounds.removeFromBottom(8);
+
+    auto sequencerBar = sequencerArea.removeFromTop(28).withTrimmedLeft(110).reduced(0, 3);
+    patternLabel.setBounds(sequencerBar.removeFromLeft(64));
+    sequencerBar.removeFromLeft(4);
+    patternBox.setBounds(sequencerBar.removeFromLeft(56));
+    sequencerBar.removeFromLeft(8);
+    lengthLabel.setBounds(sequencerBar.removeFromLeft(56));
+    sequencerBar.removeFromLeft(4);
+    lengthBox.setBounds(sequencerBar.removeFromLeft(60));
+    sequencerBar.removeFromLeft(8);
+    pageLabel.setBounds(sequencerBar.removeFromLeft(50));
+    sequencerBar.removeFromLeft(4);
+    pageBox.setBounds(sequencerBar.removeFromLeft(84));
+    sequencerBar.removeFromLeft(8);
+    chainLabel.setBounds(sequencerBar.removeFromLeft(50));
+    sequencerBar.removeFromLeft(4);
+    chainEditor.setBounds(sequencerBar.removeFromLeft(180));
+    sequencerBar.removeFromLeft(12);
+    loopButton.setBounds(sequencerBar.removeFromLeft(70));
+    sequencerBar.removeFromLeft(4);
+    followHostButton.setBounds(sequencerBar.removeFromLeft(120));
+
+    stepGrid.setBounds(sequencerArea.reduced(10, 4));
+
     const int cardGap = 8;
     const int cardWidth = (bounds.getWidth() - (cardGap * 3)) / 4;
     const int cardHeight = (bounds.getHeight() - cardGap) / 2;
@@ -8,7 +8,8 @@
 
 #include "PluginProcessor.h"
 
-class BurialDrumPluginAudioProcessorEditor final : public juce::AudioProcessorEditor
+class BurialDrumPluginAudioProcessorEditor final : public juce::AudioProcessorEditor,
+                                                   private juce::Timer
 {
 public:
     explicit BurialDrumPluginAudioProcessorEditor(BurialDrumPluginAudioProcessor&);
@@ -19,18 +20,38 @@ public:
 
 private:
     using SliderAttachment = juce::AudioProcessorValueTreeState::SliderAttachment;
+    using ButtonAttachment = juce::AudioProcessorValueTreeState::ButtonAttachment;
 
     static constexpr int drumCount = 8;
+    static constexpr int stepsPerPage = 32;
 
     struct RetroLookAndFeel final : juce::LookAndFeel_V4
     {
         RetroLookAndFeel();
     };
 
+    // One page of the selected pattern: a row per drum and a column per 16th.
+    // Clicking a step cycles it through off, soft and accented.
+    struct StepGrid final : juce::Component
+    {
+        explicit StepGrid(BurialDrumPluginAudioProcessor& p) : processor(p) {}
+
+        void paint(juce::Graphics&) override;
+        void mouseDown(const juce::MouseEvent&) override;
+
+        BurialDrumPluginAudioProcessor& processor;
+        int pattern = 0;
+        int page = 0;
+    };
+
     void configureSlider(juce::Slider& slider, juce::Label& label, const juce::String& text, bool compact = false);
     void applyPreset(int presetIndex);
     void setParameterValue(const juce::String& paramId, float plainValue);
     void stepPreset(int delta);
+    void configureSequencerLabel(juce::Label& label, const juce::String& text);
+    void applySequencerChain();
+    void refreshSequencer();
+    void timerCallback() override;
 
     BurialDrumPluginAudioProcessor& audioProcessor;
     RetroLookAndFeel retroLookAndFeel;
@@ -40,7 +61,22 @@ private:
     juce::TextButton prevPresetButton { "Prev" };
     juce::TextButton nextPresetButton { "Next" };
     juce::TextButton testSequenceButton { "Play Test Sequence" };
+    juce::TextButton stopSequenceButton { "Stop Sequence" };
     juce::Label infoLabel;
+    juce::Label partialsLabel;
+
+    juce::Label patternLabel;
+    juce::Label lengthLabel;
+    juce::Label pageLabel;
+    juce::Label chainLabel;
+    juce::ComboBox patternBox;
+    juce::ComboBox lengthBox;
+    juce::ComboBox pageBox;
+    juce::TextEditor chainEditor;
+    juce::ToggleButton loopButton { "LOOP" };
+    juce::ToggleButton followHostButton { "FOLLOW HOST" };
+    StepGrid stepGrid { audioProcessor };
+    int shownSequencerChanges = -1;
 
     juce::Slider tuneSlider;
     juce::Slider decaySlider;
@@ -75,6 +111,7 @@ private:
     std::unique_ptr<SliderAttachment> driveAttachment;
     std::unique_ptr<SliderAttachment> hatLengthAttachment;
     std::unique_ptr<SliderAttachment> swingAttachment;
+    std::unique_ptr<ButtonAttachment> followHostAttachment;
 
     std::array<std::unique_ptr<SliderAttachment>, drumCount> drumLevelAttachments;
     std::array<std::unique_ptr<SliderAttachment>, drumCount> drumTuneAttachments;
@@ -1,5 +1,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "DrumDsp.h"
 
 #include <algorithm>
 #include <cstdint>
@@ -13,6 +14,16 @@ constexpr float twoPi = juce::MathConstants<float>::twoPi;
 constexpr double testSequenceBpm = 168.0;
 constexpr int testSequenceSteps = 32;
 
+// Fade applied to a voice that is stolen, choked or over its drum's cap.
+constexpr float voiceFadeSeconds = 0.005f;
+
+// Ramp time of the continuous sound parameters.
+constexpr double parameterSmoothingSeconds = 0.02;
+
+// Delay of the comb that widens a drum, and how far it is mixed in at full width.
+constexpr double widthDelaySeconds = 0.0006;
+constexpr float maxWidthSide = 0.7f;
+
 constexpr std::array<const char*, 8> drumIdPrefixes {
     "kick", "snare", "closedHat", "openHat", "crash", "ride", "clap", "rim"
 };
@@ -21,6 +32,64 @@ constexpr std::array<const char*, 8> drumNames {
     "Kick", "Snare", "Closed Hat", "Open Hat", "Crash", "Ride", "Clap", "Rim"
 };
 
+// Default voice caps, and choke groups where 0 is none: the hats share one.
+constexpr int maxDrumVoices = 16;
+constexpr std::array<int, 8> defaultDrumVoices { 4, 4, 4, 4, 3, 4, 3, 4 };
+constexpr std::array<int, 8> defaultChokeGroups { 0, 0, 1, 1, 0, 0, 0, 0 };
+
+// Cymbals start slightly wide; everything starts centred.
+constexpr std::array<float, 8> defaultDrumWidths { 0.0f, 0.0f, 0.15f, 0.15f, 0.3f, 0.3f, 0.0f, 0.0f };
+
+// Built-in grooves, after "Off" and before "User" in the Groove choice. Hits
+// can only be moved later than they arrive, so every offset is a delay.
+using GrooveTemplate = BurialDrumPluginAudioProcessor::GrooveTemplate;
+
+constexpr std::array<GrooveTemplate, 3> grooveTemplates {{
+    { 0.0f, 0.0f, 0.0f, 0.0f, 0.15f, 0.08f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.15f, 0.08f, 0.0f, 0.0f }, // Lazy Backbeat
+    { 0.0f, 0.10f, 0.06f, 0.10f, 0.0f, 0.10f, 0.06f, 0.10f, 0.0f, 0.10f, 0.06f, 0.10f, 0.0f, 0.10f, 0.06f, 0.10f }, // Drag
+    { 0.0f, 0.05f, 0.12f, 0.02f, 0.04f, 0.10f, 0.0f, 0.14f, 0.0f, 0.06f, 0.10f, 0.03f, 0.05f, 0.12f, 0.0f, 0.08f }  // Stagger
+}};
+
+constexpr float maxGrooveDelay = 0.5f;
+
+// Adds src to dst with a gain that starts at gain and moves by step each
+// sample; a fixed gain takes the vectorised path.
+void addWithGainRamp(float* dst, const float* src, int numSamples, float gain, float step)
+{
+    if (juce::exactlyEqual(step, 0.0f))
+    {
+        if (!juce::exactlyEqual(gain, 0.0f))
+            juce::FloatVectorOperations::addWithMultiply(dst, src, gain, numSamples);
+        return;
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+        dst[i] += src[i] * (gain + step * static_cast<float>(i));
+}
+
+// One of the master chain's one-pole lowpasses, from in to out. Outside the
+// rendered span the state is cleared wherever the mix is silent, so a tail
+// that has died away restarts from zero; the span runs block-parallel.
+void masterOnePole(const float* mix, const float* in, float* out, int numSamples, int spanStart, int spanEnd,
+                   float coeff, float& state)
+{
+    const auto runClearingOnSilence = [&](int start, int end)
+    {
+        for (int i = start; i < end; ++i)
+        {
+            if (std::abs(mix[i]) < 1.0e-7f)
+                state = 0.0f;
+
+            state += coeff * (in[i] - state);
+            out[i] = state;
+        }
+    };
+
+    runClearingOnSilence(0, spanStart);
+    drumdsp::onePoleLowpassBlock(in + spanStart, out + spanStart, spanEnd - spanStart, coeff, state);
+    runClearingOnSilence(spanEnd, numSamples);
+}
+
 struct SequenceHit
 {
     int step;
@@ -62,26 +131,304 @@ constexpr std::array<SequenceHit, 30> testPattern {
     SequenceHit { 31, BurialDrumPluginAudioProcessor::DrumType::clap,      0.50f }
 };
 
-float expDecay(float t, float tau)
+using DrumType = BurialDrumPluginAudioProcessor::DrumType;
+
+// Per-drum constants the render kernels are specialised on.
+struct DrumModel
+{
+    std::array<float, 3> partialHz; // Fixed partial frequencies; zero where a drum sweeps or has none.
+    int noisePerSample;             // Noise draws the kernel takes per output sample.
+};
+
+constexpr std::array<DrumModel, 8> drumModels {{
+    { { 0.0f,    0.0f,    0.0f    }, 1 }, // kick
+    { { 0.0f,    0.0f,    0.0f    }, 2 }, // snare
+    { { 7340.0f, 9170.0f * 1.733f, 0.0f }, 1 },            // closedHat
+    { { 6100.0f, 7420.0f * 1.91f, 9030.0f * 2.27f }, 1 }, // openHat
+    { { 4540.0f, 5920.0f, 7440.0f }, 1 }, // crash
+    { { 3890.0f, 5280.0f, 0.0f    }, 1 }, // ride
+    { { 0.0f,    0.0f,    0.0f    }, 1 }, // clap
+    { { 940.0f,  1490.0f, 0.0f    }, 1 }  // rim
+}};
+
+// Samples rendered per noise block fill inside a kernel.
+constexpr int noiseChunkSamples = 64;
+
+// Envelope set of each drum, anchored at the voice's time t once per span.
+// level() bounds the drum's output before tone and drive from the current
+// envelope values, with every oscillator and noise source at full scale.
+template <DrumType type, typename SampleType>
+struct DrumEnvelopes;
+
+template <typename SampleType>
+struct DrumEnvelopes<DrumType::kick, SampleType>
+{
+    drumdsp::DecayEnvelope<SampleType> sweep, amp, click, sub;
+
+    void reset(SampleType t, float decayMul, float, float dt) noexcept
+    {
+        sweep.reset(t, 0.010f * decayMul, dt);
+        amp.reset(t, 0.14f * decayMul, dt);
+        click.reset(t, 0.0019f, dt);
+        sub.reset(t, 0.16f * decayMul, dt);
+    }
+
+    SampleType level() const noexcept
+    {
+        return amp.value * 1.02f + sub.value * 0.60f + click.value * 0.66f;
+    }
+};
+
+template <typename SampleType>
+struct DrumEnvelopes<DrumType::snare, SampleType>
+{
+    drumdsp::DecayEnvelope<SampleType> body, noise, sweep, crack;
+
+    void reset(SampleType t, float decayMul, float, float dt) noexcept
+    {
+        body.reset(t, 0.082f * decayMul, dt);
+        noise.reset(t, 0.058f * decayMul, dt);
+        sweep.reset(t, 0.009f * decayMul, dt);
+        crack.reset(t, 0.0024f, dt);
+    }
+
+    SampleType level() const noexcept
+    {
+        return body.value * 0.90f + noise.value * 0.66f + crack.value * 0.94f;
+    }
+};
+
+template <typename SampleType>
+struct DrumEnvelopes<DrumType::closedHat, SampleType>
+{
+    drumdsp::DecayEnvelope<SampleType> amp;
+
+    void reset(SampleType t, float decayMul, float hatMul, float dt) noexcept
+    {
+        amp.reset(t, 0.018f * decayMul * hatMul, dt);
+    }
+
+    SampleType level() const noexcept
+    {
+        return amp.value * 1.38f;
+    }
+};
+
+template <typename SampleType>
+struct DrumEnvelopes<DrumType::openHat, SampleType>
+{
+    drumdsp::DecayEnvelope<SampleType> amp;
+
+    void reset(SampleType t, float decayMul, float hatMul, float dt) noexcept
+    {
+        amp.reset(t, 0.045f * decayMul * hatMul, dt);
+    }
+
+    SampleType level() const noexcept
+    {
+        return amp.value * 1.64f;
+    }
+};
+
+template <typename SampleType>
+struct DrumEnvelopes<DrumType::crash, SampleType>
 {
-    return std::exp(-t / juce::jmax(tau, 1.0e-5f));
+    drumdsp::AttackDecayEnvelope<SampleType> amp;
+    drumdsp::DecayEnvelope<SampleType> noise;
+
+    void reset(SampleType t, float decayMul, float hatMul, float dt) noexcept
+    {
+        amp.reset(t, 0.002f, 0.18f * decayMul * hatMul, dt);
+        noise.reset(t, 0.095f * decayMul * hatMul, dt);
+    }
+
+    SampleType level() const noexcept
+    {
+        return amp.attack.value * amp.decay.value * (noise.value * 0.22f + 0.94f);
+    }
+};
+
+template <typename SampleType>
+struct DrumEnvelopes<DrumType::ride, SampleType>
+{
+    drumdsp::AttackDecayEnvelope<SampleType> amp;
+    drumdsp::DecayEnvelope<SampleType> noise, ping, tail;
+
+    void reset(SampleType t, float decayMul, float hatMul, float dt) noexcept
+    {
+        amp.reset(t, 0.0018f, 0.19f * decayMul * hatMul, dt);
+        noise.reset(t, 0.085f * decayMul * hatMul, dt);
+        ping.reset(t, 0.10f * decayMul, dt);
+        tail.reset(t, 0.15f * decayMul, dt);
+    }
+
+    SampleType level() const noexcept
+    {
+        return amp.attack.value * amp.decay.value * (noise.value * 0.20f + ping.value + tail.value * 0.20f);
+    }
+};
+
+template <typename SampleType>
+struct DrumEnvelopes<DrumType::clap, SampleType>
+{
+    drumdsp::MultiBurstEnvelope<SampleType> amp;
+
+    void reset(SampleType t, float decayMul, float, float dt) noexcept
+    {
+        amp.reset(t,
+                  { 0.0f, 0.012f * decayMul, 0.022f * decayMul },
+                  { 0.015f * decayMul, 0.013f * decayMul, 0.028f * decayMul },
+                  dt);
+    }
+
+    SampleType level() const noexcept
+    {
+        return drumdsp::Lanes<SampleType>::min(amp.bursts[0].value + amp.bursts[1].value + amp.bursts[2].value, SampleType(1.0f));
+    }
+};
+
+template <typename SampleType>
+struct DrumEnvelopes<DrumType::rim, SampleType>
+{
+    drumdsp::DecayEnvelope<SampleType> amp, tick;
+
+    void reset(SampleType t, float decayMul, float, float dt) noexcept
+    {
+        amp.reset(t, 0.050f * decayMul, dt);
+        tick.reset(t, 0.0032f, dt);
+    }
+
+    SampleType level() const noexcept
+    {
+        return amp.value * (tick.value * 0.50f + 1.25f);
+    }
+};
+
+constexpr size_t countPartials(const DrumModel& model)
+{
+    size_t count = 0;
+    for (const auto hz : model.partialHz)
+        count += hz > 0.0f ? 1 : 0;
+
+    return count;
+}
+
+// Fraction of the host's Nyquist frequency above which fixed partials fade out.
+constexpr float partialBandLimit = 0.94f;
+
+// Decay scaling at the top of the global and per-drum Decay and Hat Length ranges.
+constexpr float maxDecayMul = 1.8f * 2.0f;
+constexpr float maxHatMul = 2.0f;
+
+// Voices are never retired inside their first 10 ms, which also keeps the
+// search below clear of the crash and ride attack ramps.
+constexpr float minVoiceSeconds = 0.01f;
+
+// Bottom of the Voice Retire Level range.
+constexpr float minRetireLevelDb = -120.0f;
+
+template <DrumType type>
+float envelopeLevel(float t, float decayMul, float hatMul)
+{
+    DrumEnvelopes<type, float> env;
+    env.reset(t, decayMul, hatMul, 0.0f);
+    return env.level();
+}
+
+// Envelope level of a drum t seconds after it was hit.
+float drumEnvelopeLevel(DrumType type, float t, float decayMul, float hatMul)
+{
+    switch (type)
+    {
+        case DrumType::kick:      return envelopeLevel<DrumType::kick>(t, decayMul, hatMul);
+        case DrumType::snare:     return envelopeLevel<DrumType::snare>(t, decayMul, hatMul);
+        case DrumType::closedHat: return envelopeLevel<DrumType::closedHat>(t, decayMul, hatMul);
+        case DrumType::openHat:   return envelopeLevel<DrumType::openHat>(t, decayMul, hatMul);
+        case DrumType::crash:     return envelopeLevel<DrumType::crash>(t, decayMul, hatMul);
+        case DrumType::ride:      return envelopeLevel<DrumType::ride>(t, decayMul, hatMul);
+        case DrumType::clap:      return envelopeLevel<DrumType::clap>(t, decayMul, hatMul);
+        case DrumType::rim:       return envelopeLevel<DrumType::rim>(t, decayMul, hatMul);
+        case DrumType::none:      break;
+    }
+
+    return 0.0f;
 }
 
-float smoothAttack(float t, float attack)
+// Length in samples after which a hit scaled by gain stays below threshold.
+// Every envelope set only decays once past its attack, so the first silent
+// sample is found by a doubling search followed by bisection.
+int samplesUntilSilent(DrumType type, float gain, float threshold, float decayMul, float hatMul, float invSampleRate)
 {
-    if (attack <= 0.0f)
-        return 1.0f;
+    const int minSamples = juce::jmax(1, static_cast<int>(minVoiceSeconds / invSampleRate));
+    if (threshold <= 0.0f || gain <= threshold * 1.0e-3f)
+        return minSamples;
+
+    const float floor = threshold / gain;
+    auto isSilent = [&](int n)
+    {
+        return drumEnvelopeLevel(type, static_cast<float>(n) * invSampleRate, decayMul, hatMul) < floor;
+    };
+
+    if (isSilent(minSamples))
+        return minSamples;
+
+    int loud = minSamples;
+    int silent = minSamples * 2;
+    while (!isSilent(silent))
+    {
+        loud = silent;
+        silent *= 2;
+    }
+
+    while (silent - loud > 1)
+    {
+        const int mid = loud + (silent - loud) / 2;
+        if (isSilent(mid))
+            silent = mid;
+        else
+            loud = mid;
+    }
 
-    return juce::jlimit(0.0f, 1.0f, t / attack);
+    return silent;
 }
 
 } // namespace
 
 BurialDrumPluginAudioProcessor::BurialDrumPluginAudioProcessor()
-    : AudioProcessor(BusesProperties().withOutput("Output", juce::AudioChannelSet::stereo(), true)),
+    : AudioProcessor(createBusesProperties()),
       parameters(*this, nullptr, "PARAMETERS", createParameterLayout())
 {
     cacheParameterPointers();
+
+    // The filters' latency does not depend on the sample rate, so a new tier
+    // can be reported to the host before playback is prepared with it.
+    for (size_t order = 1; order < oversamplingLatencies.size(); ++order)
+    {
+        juce::dsp::Oversampling<float> oversampler(1, order, juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true, true);
+        oversampler.initProcessing(1);
+        oversamplingLatencies[order] = juce::roundToInt(oversampler.getLatencyInSamples());
+    }
+
+    parameters.addParameterListener("oversampling", this);
+
+    resetSequencerEdits();
+    sequencer.publish(sequencerEdits);
+}
+
+BurialDrumPluginAudioProcessor::~BurialDrumPluginAudioProcessor()
+{
+    parameters.removeParameterListener("oversampling", this);
+    cancelPendingUpdate();
+}
+
+juce::AudioProcessor::BusesProperties BurialDrumPluginAudioProcessor::createBusesProperties()
+{
+    // A stereo main output, plus a disabled output per drum for hosts to enable.
+    auto buses = BusesProperties().withOutput("Output", juce::AudioChannelSet::stereo(), true);
+    for (const auto* name : drumNames)
+        buses = buses.withOutput(name, juce::AudioChannelSet::stereo(), false);
+
+    return buses;
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout BurialDrumPluginAudioProcessor::createParameterLayout()
@@ -93,6 +440,16 @@ juce::AudioProcessorValueTreeState::ParameterLayout BurialDrumPluginAudioProcess
     layout.push_back(std::make_unique<juce::AudioParameterFloat>("drive", "Drive", juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f), 0.28f));
     layout.push_back(std::make_unique<juce::AudioParameterFloat>("hatLength", "Hat Length", juce::NormalisableRange<float>(0.2f, 2.0f, 0.001f), 0.82f));
     layout.push_back(std::make_unique<juce::AudioParameterFloat>("swing", "Swing", juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f), 0.0f));
+    layout.push_back(std::make_unique<juce::AudioParameterChoice>("swingDivision", "Swing Division", juce::StringArray { "8th", "16th" }, 0));
+    layout.push_back(std::make_unique<juce::AudioParameterChoice>("groove", "Groove", juce::StringArray { "Off", "Lazy Backbeat", "Drag", "Stagger", "User" }, 0));
+    layout.push_back(std::make_unique<juce::AudioParameterBool>("sequencerFollow", "Sequencer Follows Host", false));
+    layout.push_back(std::make_unique<juce::AudioParameterBool>("hitCache", "Hit Cache", false));
+    layout.push_back(std::make_unique<juce::AudioParameterBool>("stemMasterChain", "Per-Drum Output Master Chain", true));
+    layout.push_back(std::make_unique<juce::AudioParameterFloat>("retireLevel", "Voice Retire Level", juce::NormalisableRange<float>(minRetireLevelDb, -60.0f, 0.1f), -90.0f));
+    layout.push_back(std::make_unique<juce::AudioParameterInt>("seed", "Random Seed", 0, 9999, 0));
+    layout.push_back(std::make_unique<juce::AudioParameterInt>("polyphony", "Polyphony", minPolyphony, maxPolyphony, 32));
+    layout.push_back(std::make_unique<juce::AudioParameterChoice>("driveQuality", "Drive Quality", juce::StringArray { "Exact", "Fast", "Table" }, 1));
+    layout.push_back(std::make_unique<juce::AudioParameterChoice>("oversampling", "Oversampling", juce::StringArray { "Auto", "1x", "2x", "4x" }, 0));
 
     for (size_t i = 0; i < drumIdPrefixes.size(); ++i)
     {
@@ -128,6 +485,31 @@ juce::AudioProcessorValueTreeState::ParameterLayout BurialDrumPluginAudioProcess
             name + " Drive",
             juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f),
             (i < 2 ? 0.34f : 0.22f)));
+
+        layout.push_back(std::make_unique<juce::AudioParameterInt>(
+            prefix + "Voices",
+            name + " Voices",
+            1,
+            maxDrumVoices,
+            defaultDrumVoices[i]));
+
+        layout.push_back(std::make_unique<juce::AudioParameterChoice>(
+            prefix + "Choke",
+            name + " Choke Group",
+            juce::StringArray { "None", "1", "2", "3", "4" },
+            defaultChokeGroups[i]));
+
+        layout.push_back(std::make_unique<juce::AudioParameterFloat>(
+            prefix + "Pan",
+            name + " Pan",
+            juce::NormalisableRange<float>(-1.0f, 1.0f, 0.001f),
+            0.0f));
+
+        layout.push_back(std::make_unique<juce::AudioParameterFloat>(
+            prefix + "Width",
+            name + " Width",
+            juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f),
+            defaultDrumWidths[i]));
     }
 
     return { layout.begin(), layout.end() };
@@ -181,31 +563,268 @@ void BurialDrumPluginAudioProcessor::cacheParameterPointers()
         drumDecayParams[i] = parameters.getRawParameterValue(prefix + "Decay");
         drumToneParams[i] = parameters.getRawParameterValue(prefix + "Tone");
         drumDriveParams[i] = parameters.getRawParameterValue(prefix + "Drive");
+        drumVoicesParams[i] = parameters.getRawParameterValue(prefix + "Voices");
+        drumChokeParams[i] = parameters.getRawParameterValue(prefix + "Choke");
+        drumPanParams[i] = parameters.getRawParameterValue(prefix + "Pan");
+        drumWidthParams[i] = parameters.getRawParameterValue(prefix + "Width");
     }
+
+    swingParam = parameters.getRawParameterValue("swing");
+    swingDivisionParam = parameters.getRawParameterValue("swingDivision");
+    grooveParam = parameters.getRawParameterValue("groove");
+    sequencerFollowParam = parameters.getRawParameterValue("sequencerFollow");
+}
+
+void BurialDrumPluginAudioProcessor::VoicePool::clear(int slotCount)
+{
+    type.fill(DrumType::none);
+    velocity.fill(0.0f);
+    sampleIndex.fill(0);
+    endSample.fill(0);
+    for (auto& partial : partials)
+        partial.fill({});
+    noise.fill({});
+    cacheEntry.fill(-1);
+    cacheRecording.fill(false);
+    toneState.fill(0.0f);
+    fadeGain.fill(1.0f);
+    fadeStep.fill(0.0f);
+    numFading = 0;
+    activePosition.fill(-1);
+    numActive = 0;
+
+    setNumSlots(slotCount);
+}
+
+void BurialDrumPluginAudioProcessor::VoicePool::setNumSlots(int slotCount)
+{
+    numSlots = juce::jlimit(0, maxVoices, slotCount);
+
+    // Lowest slots are handed out first. Voices sounding in slots past a
+    // reduced count play out and are not returned to the free list.
+    numFree = 0;
+    for (int slot = numSlots; --slot >= 0;)
+        if (!isActive(slot))
+            freeVoices[static_cast<size_t>(numFree++)] = slot;
+}
+
+int BurialDrumPluginAudioProcessor::VoicePool::allocate()
+{
+    if (numFree == 0)
+        return -1;
+
+    const int slot = freeVoices[static_cast<size_t>(--numFree)];
+    activePosition[static_cast<size_t>(slot)] = numActive;
+    activeVoices[static_cast<size_t>(numActive)] = slot;
+    ++numActive;
+    return slot;
+}
+
+void BurialDrumPluginAudioProcessor::VoicePool::release(int slot)
+{
+    const auto i = static_cast<size_t>(slot);
+    const int position = activePosition[i];
+    if (position < 0)
+        return;
+
+    // Swap-remove keeps the active list compact.
+    const int lastSlot = activeVoices[static_cast<size_t>(numActive - 1)];
+    activeVoices[static_cast<size_t>(position)] = lastSlot;
+    activePosition[static_cast<size_t>(lastSlot)] = position;
+    activePosition[i] = -1;
+    --numActive;
+
+    if (isFading(slot))
+        --numFading;
+
+    fadeGain[i] = 1.0f;
+    fadeStep[i] = 0.0f;
+
+    if (slot < numSlots)
+        freeVoices[static_cast<size_t>(numFree++)] = slot;
+}
+
+void BurialDrumPluginAudioProcessor::VoicePool::startFade(int slot, float step)
+{
+    if (!isActive(slot) || isFading(slot))
+        return;
+
+    fadeStep[static_cast<size_t>(slot)] = step;
+    ++numFading;
 }
 
-void BurialDrumPluginAudioProcessor::prepareToPlay(double sampleRate, int)
+BurialDrumPluginAudioProcessor::Voice BurialDrumPluginAudioProcessor::VoicePool::load(int slot) const
+{
+    const auto i = static_cast<size_t>(slot);
+
+    Voice v;
+    v.active = isActive(slot);
+    v.type = type[i];
+    v.velocity = velocity[i];
+    v.sampleIndex = sampleIndex[i];
+    v.endSample = endSample[i];
+    for (size_t k = 0; k < partials.size(); ++k)
+        v.partials[k] = partials[k][i];
+    v.noise = noise[i];
+    v.toneState = toneState[i];
+    return v;
+}
+
+void BurialDrumPluginAudioProcessor::VoicePool::store(int slot, const Voice& v)
+{
+    const auto i = static_cast<size_t>(slot);
+
+    sampleIndex[i] = v.sampleIndex;
+    for (size_t k = 0; k < partials.size(); ++k)
+        partials[k][i] = v.partials[k];
+    noise[i] = v.noise;
+    toneState[i] = v.toneState;
+}
+
+void BurialDrumPluginAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
     currentSampleRate = juce::jmax(8000.0, sampleRate);
-    lpStateL = 0.0f;
-    lpStateR = 0.0f;
-    punchHPState = 0.0f;
 
-    for (auto& v : voices)
-        v = {};
+    // The tier only changes here, with no voice sounding. A change made
+    // since the last call has already been reported to the host.
+    oversamplingChangePending = false;
+    const int oversamplingOrder = getOversamplingOrder();
+    oversamplingFactor = 1 << oversamplingOrder;
+    renderSampleRate = currentSampleRate * oversamplingFactor;
+
+    mixOversampler.reset();
+    stemOversampler.reset();
+    lastBlockRenderedStems = false;
+    oversamplersHoldSignal = false;
+
+    if (oversamplingOrder > 0)
+    {
+        const auto filter = juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR;
+        mixOversampler = std::make_unique<juce::dsp::Oversampling<float>>(1, static_cast<size_t>(oversamplingOrder), filter, true, true);
+        stemOversampler = std::make_unique<juce::dsp::Oversampling<float>>(drumCount, static_cast<size_t>(oversamplingOrder), filter, true, true);
+        mixOversampler->initProcessing(static_cast<size_t>(juce::jmax(1, samplesPerBlock)));
+        stemOversampler->initProcessing(static_cast<size_t>(juce::jmax(1, samplesPerBlock)));
+    }
+
+    setLatencySamples(oversamplingLatencies[static_cast<size_t>(oversamplingOrder)]);
+
+    mixBuffer.setSize(3, juce::jmax(1, samplesPerBlock) * oversamplingFactor);
+    masterChain = {};
+    stemMasterChains.fill({});
+
+    stemOutputsEnabled = false;
+    for (int bus = 1; bus < getBusCount(false); ++bus)
+        stemOutputsEnabled = stemOutputsEnabled || getBus(false, bus)->isEnabled();
+
+    stemBuffer.setSize(drumCount, juce::jmax(1, samplesPerBlock));
+    widthDelaySamples = juce::jlimit(1, maxWidthDelaySamples, juce::roundToInt(widthDelaySeconds * currentSampleRate));
+    for (auto& history : widthHistory)
+        history.fill(0.0f);
+
+    updateStemPlacements();
+    lastStemPlacements = stemPlacements;
+
+    // Ramps start at rest on the current settings.
+    setSmootherTargets();
+    for (auto* smoother : { &tuneSmoother, &decaySmoother, &toneSmoother, &driveSmoother, &hatLengthSmoother })
+    {
+        smoother->reset(currentSampleRate, parameterSmoothingSeconds);
+        smoother->setCurrentAndTargetValue(smoother->getTargetValue());
+    }
+
+    for (auto* smoothers : { &drumLevelSmoothers, &drumTuneSmoothers, &drumDecaySmoothers, &drumToneSmoothers, &drumDriveSmoothers })
+    {
+        for (auto& smoother : *smoothers)
+        {
+            smoother.reset(currentSampleRate, parameterSmoothingSeconds);
+            smoother.setCurrentAndTargetValue(smoother.getTargetValue());
+        }
+    }
+
+    voicePool.clear(0);
+    applyPolyphony(juce::roundToInt(parameters.getRawParameterValue("polyphony")->load()));
+
+    // Commands sent while stopped are stale by now.
+    commandFifo.reset();
+    voiceFadeStep = 1.0f / (voiceFadeSeconds * static_cast<float>(renderSampleRate));
+    pendingHits.clear();
+    blockStartSample = 0;
+    lastHitTime = -1;
+    hitsAtSameTime = 0;
+
+    // Longest hit at full level, velocity and drive with the lowest retire level.
+    const float invSampleRate = static_cast<float>(1.0 / renderSampleRate);
+    const float maxGain = 1.5f * std::sqrt(1.0f + 6.6f);
+    const float minThreshold = juce::Decibels::decibelsToGain(minRetireLevelDb, minRetireLevelDb - 1.0f);
+
+    int maxHitSamples = 0;
+    for (size_t i = 0; i < drumModels.size(); ++i)
+        maxHitSamples = juce::jmax(maxHitSamples, samplesUntilSilent(static_cast<DrumType>(i), maxGain, minThreshold,
+                                                                     maxDecayMul, maxHatMul, invSampleRate));
 
-    testSequencePlaying = false;
-    testSequenceSampleCursor = 0;
+    hitCache.prepare(hitCacheBytes, maxHitSamples, hitCacheEntries);
+    hitCacheNextVariation.fill(0);
+
+    sequencer.reset();
+    sequencerStartedByHost = false;
 }
 
 void BurialDrumPluginAudioProcessor::releaseResources()
 {
 }
 
+void BurialDrumPluginAudioProcessor::setNonRealtime(bool isNonRealtime) noexcept
+{
+    AudioProcessor::setNonRealtime(isNonRealtime);
+
+    // Auto follows the render mode.
+    oversamplingChangePending = true;
+    triggerAsyncUpdate();
+}
+
+void BurialDrumPluginAudioProcessor::parameterChanged(const juce::String&, float)
+{
+    // Automation can arrive on the audio thread, so the tier is left alone
+    // here and the host is told about its latency from the message thread.
+    oversamplingChangePending = true;
+    triggerAsyncUpdate();
+}
+
+void BurialDrumPluginAudioProcessor::handleAsyncUpdate()
+{
+    // Reporting the new tier's latency prompts hosts to prepare playback
+    // again, which is where the tier changes. Others pick it up the next
+    // time they prepare.
+    if (oversamplingChangePending)
+        setLatencySamples(oversamplingLatencies[static_cast<size_t>(getOversamplingOrder())]);
+}
+
+int BurialDrumPluginAudioProcessor::getOversamplingOrder() const
+{
+    // Auto renders at the host rate while tracking and at 4x when bouncing.
+    const int choice = juce::roundToInt(parameters.getRawParameterValue("oversampling")->load());
+    return choice == 0 ? (isNonRealtime() ? maxOversamplingOrder : 0) : juce::jlimit(0, maxOversamplingOrder, choice - 1);
+}
+
 bool BurialDrumPluginAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
 {
-    return layouts.getMainOutputChannelSet() == juce::AudioChannelSet::mono()
-        || layouts.getMainOutputChannelSet() == juce::AudioChannelSet::stereo();
+    const auto isMonoOrStereo = [](const juce::AudioChannelSet& set)
+    {
+        return set == juce::AudioChannelSet::mono() || set == juce::AudioChannelSet::stereo();
+    };
+
+    if (!isMonoOrStereo(layouts.getMainOutputChannelSet()))
+        return false;
+
+    // Per-drum outputs can each be off, mono or stereo.
+    for (int bus = 1; bus < layouts.outputBuses.size(); ++bus)
+    {
+        const auto& set = layouts.outputBuses.getReference(bus);
+        if (!set.isDisabled() && !isMonoOrStereo(set))
+            return false;
+    }
+
+    return true;
 }
 
 BurialDrumPluginAudioProcessor::DrumType BurialDrumPluginAudioProcessor::noteToDrumType(int midiNote) const
@@ -224,309 +843,1292 @@ BurialDrumPluginAudioProcessor::DrumType BurialDrumPluginAudioProcessor::noteToD
     }
 }
 
-void BurialDrumPluginAudioProcessor::triggerDrum(DrumType type, float velocity, int sampleOffset)
+float BurialDrumPluginAudioProcessor::voiceLevel(int slot) const
 {
-    auto it = std::find_if(voices.begin(), voices.end(), [](const Voice& v) { return !v.active; });
+    const auto i = static_cast<size_t>(slot);
+    const int drumIndex = drumTypeToIndex(voicePool.type[i]);
+    if (drumIndex < 0)
+        return 0.0f;
 
-    if (it == voices.end())
-        it = std::min_element(voices.begin(), voices.end(), [](const Voice& a, const Voice& b) { return a.sampleIndex > b.sampleIndex; });
+    const auto& p = drumBlockParams[static_cast<size_t>(drumIndex)];
+    const float t = static_cast<float>(voicePool.sampleIndex[i]) * p.invSampleRate;
 
-    it->active = true;
-    it->type = type;
-    it->velocity = juce::jlimit(0.0f, 1.0f, velocity);
-    it->samplesUntilStart = juce::jmax(0, sampleOffset);
-    it->sampleIndex = 0;
-    it->phaseA = random01(rng) * twoPi;
-    it->phaseB = random01(rng) * twoPi;
-    it->phaseC = random01(rng) * twoPi;
-    it->noiseState = static_cast<uint32_t>(rng()) | 1u;
-    it->toneState = 0.0f;
+    return drumEnvelopeLevel(voicePool.type[i], t, p.decayMul, p.hatMul) * voiceGain(slot) * voicePool.fadeGain[i];
 }
 
-float BurialDrumPluginAudioProcessor::nextNoiseSample(uint32_t& state)
+float BurialDrumPluginAudioProcessor::voiceGain(int slot) const
 {
-    // Xorshift32: fast decorrelated noise without periodic tonal artifacts.
-    state ^= state << 13;
-    state ^= state >> 17;
-    state ^= state << 5;
-    const float normalized = static_cast<float>(state & 0x00ffffffu) / static_cast<float>(0x01000000u);
-    return normalized * 2.0f - 1.0f;
+    const auto i = static_cast<size_t>(slot);
+    const auto& p = drumBlockParams[static_cast<size_t>(drumTypeToIndex(voicePool.type[i]))];
+
+    // Small-signal gain of the drive stage is driveGain * driveTrim.
+    return (0.35f + 0.65f * voicePool.velocity[i]) * p.level * p.driveGain * p.driveTrim;
 }
 
-float BurialDrumPluginAudioProcessor::softClip(float x)
+int BurialDrumPluginAudioProcessor::voiceEndSample(int slot) const
 {
-    return std::tanh(x);
+    const auto i = static_cast<size_t>(slot);
+    const int drumIndex = drumTypeToIndex(voicePool.type[i]);
+    if (drumIndex < 0)
+        return 0;
+
+    const auto& p = drumBlockParams[static_cast<size_t>(drumIndex)];
+    return samplesUntilSilent(voicePool.type[i], voiceGain(slot), p.retireLevel, p.decayMul, p.hatMul, p.invSampleRate);
 }
 
-float BurialDrumPluginAudioProcessor::renderVoiceSample(Voice& v) const
+int BurialDrumPluginAudioProcessor::findQuietestVoice(bool fading, DrumType type) const
 {
-    const int drumIndex = drumTypeToIndex(v.type);
-    if (drumIndex < 0)
+    int quietest = -1;
+    float quietestLevel = 0.0f;
+
+    for (int n = 0; n < voicePool.numActive; ++n)
     {
-        v.active = false;
-        return 0.0f;
-    }
+        const int slot = voicePool.activeVoices[static_cast<size_t>(n)];
+        if (voicePool.isFading(slot) != fading || (type != DrumType::none && voicePool.type[static_cast<size_t>(slot)] != type))
+            continue;
 
-    const float drumLevel = blockDrumLevels[static_cast<size_t>(drumIndex)];
-    const float drumTune = blockDrumTuneSemitones[static_cast<size_t>(drumIndex)];
-    const float drumDecay = blockDrumDecay[static_cast<size_t>(drumIndex)];
-    const float drumTone = blockDrumTone[static_cast<size_t>(drumIndex)];
-    const float drumDrive = blockDrumDrive[static_cast<size_t>(drumIndex)];
-
-    const float sr = static_cast<float>(currentSampleRate);
-    const float t = static_cast<float>(v.sampleIndex) / sr;
-    const float vel = 0.35f + 0.65f * v.velocity;
-    const float tuneMul = std::pow(2.0f, (blockTuneSemitones + drumTune) / 12.0f);
-    const float decayMul = blockDecay * drumDecay;
-    const float hatMul = blockHatLength;
-
-    float out = 0.0f;
-
-    switch (v.type)
-    {
-        case DrumType::kick:
-        {
-            const float freq = (46.0f + 300.0f * expDecay(t, 0.010f * decayMul)) * tuneMul;
-            const float amp = expDecay(t, 0.14f * decayMul);
-            const float click = expDecay(t, 0.0019f) * nextNoiseSample(v.noiseState);
-            v.phaseA += twoPi * freq / sr;
-            v.phaseB += twoPi * (freq * 0.5f) / sr;
-            const float thump = std::sin(v.phaseA) * amp;
-            const float sub = std::sin(v.phaseB) * expDecay(t, 0.16f * decayMul);
-            out = (thump * 1.02f) + (sub * 0.60f) + 0.66f * click;
-            if (t > 0.52f * decayMul)
-                v.active = false;
-            break;
-        }
-        case DrumType::snare:
-        {
-            const float bodyAmp = expDecay(t, 0.082f * decayMul);
-            const float noiseAmp = expDecay(t, 0.058f * decayMul);
-            const float bodyFreq = (238.0f + 130.0f * expDecay(t, 0.009f * decayMul)) * tuneMul;
-            v.phaseA += twoPi * bodyFreq / sr;
-            const float body = std::sin(v.phaseA) * bodyAmp;
-            const float noise = nextNoiseSample(v.noiseState) * noiseAmp;
-            const float crack = expDecay(t, 0.0024f) * nextNoiseSample(v.noiseState);
-            out = 0.90f * body + 0.66f * noise + 0.94f * crack;
-            if (t > 0.34f * decayMul)
-                v.active = false;
-            break;
-        }
-        case DrumType::closedHat:
-        {
-            const float env = expDecay(t, 0.018f * decayMul * hatMul);
-            const float n = nextNoiseSample(v.noiseState);
-            const float metal = std::sin(v.phaseA) + std::sin(v.phaseB * 1.733f);
-            v.phaseA += twoPi * (7340.0f * tuneMul) / sr;
-            v.phaseB += twoPi * (9170.0f * tuneMul) / sr;
-            out = (0.62f * n + 0.38f * metal) * env;
-            if (t > 0.10f * decayMul * hatMul)
-                v.active = false;
-            break;
-        }
-        case DrumType::openHat:
-        {
-            const float env = expDecay(t, 0.045f * decayMul * hatMul);
-            const float n = nextNoiseSample(v.noiseState);
-            const float metal = std::sin(v.phaseA) + 0.7f * std::sin(v.phaseB * 1.91f) + 0.4f * std::sin(v.phaseC * 2.27f);
-            v.phaseA += twoPi * (6100.0f * tuneMul) / sr;
-            v.phaseB += twoPi * (7420.0f * tuneMul) / sr;
-            v.phaseC += twoPi * (9030.0f * tuneMul) / sr;
-            out = (0.42f * n + 0.58f * metal) * env;
-            if (t > 0.24f * decayMul * hatMul)
-                v.active = false;
-            break;
-        }
-        case DrumType::crash:
-        {
-            const float env = expDecay(t, 0.18f * decayMul * hatMul) * smoothAttack(t, 0.002f);
-            const float n = nextNoiseSample(v.noiseState) * expDecay(t, 0.095f * decayMul * hatMul);
-            v.phaseA += twoPi * (4540.0f * tuneMul) / sr;
-            v.phaseB += twoPi * (5920.0f * tuneMul) / sr;
-            v.phaseC += twoPi * (7440.0f * tuneMul) / sr;
-            const float partials = 0.64f * std::sin(v.phaseA) + 0.38f * std::sin(v.phaseB) + 0.18f * std::sin(v.phaseC);
-            out = (0.22f * n + 0.78f * partials) * env;
-            if (t > 0.30f * decayMul * hatMul)
-                v.active = false;
-            break;
-        }
-        case DrumType::ride:
-        {
-            const float env = expDecay(t, 0.19f * decayMul * hatMul) * smoothAttack(t, 0.0018f);
-            const float n = nextNoiseSample(v.noiseState) * expDecay(t, 0.085f * decayMul * hatMul);
-            v.phaseA += twoPi * (3890.0f * tuneMul) / sr;
-            v.phaseB += twoPi * (5280.0f * tuneMul) / sr;
-            const float ping = std::sin(v.phaseA) * expDecay(t, 0.10f * decayMul);
-            const float tail = 0.20f * std::sin(v.phaseB) * expDecay(t, 0.15f * decayMul);
-            out = (0.20f * n + ping + tail) * env;
-            if (t > 0.34f * decayMul * hatMul)
-                v.active = false;
-            break;
-        }
-        case DrumType::clap:
-        {
-            const float burst1 = expDecay(juce::jmax(0.0f, t - 0.000f), 0.015f * decayMul);
-            const float burst2 = expDecay(juce::jmax(0.0f, t - 0.012f * decayMul), 0.013f * decayMul);
-            const float burst3 = expDecay(juce::jmax(0.0f, t - 0.022f * decayMul), 0.028f * decayMul);
-            const float env = juce::jmin(1.0f, burst1 + burst2 + burst3);
-            const float n = nextNoiseSample(v.noiseState);
-            out = n * env;
-            if (t > 0.34f * decayMul)
-                v.active = false;
-            break;
-        }
-        case DrumType::rim:
-        {
-            const float env = expDecay(t, 0.050f * decayMul);
-            v.phaseA += twoPi * (940.0f * tuneMul) / sr;
-            v.phaseB += twoPi * (1490.0f * tuneMul) / sr;
-            const float tone = std::sin(v.phaseA) + 0.6f * std::sin(v.phaseB);
-            const float tick = expDecay(t, 0.0032f) * nextNoiseSample(v.noiseState);
-            out = (0.78f * tone + 0.50f * tick) * env;
-            if (t > 0.18f * decayMul)
-                v.active = false;
-            break;
-        }
-        case DrumType::none:
-            v.active = false;
-            break;
-    }
-
-    const float toneCoeff = juce::jmap(drumTone, 0.02f, 0.62f);
-    v.toneState += toneCoeff * (out - v.toneState);
-    const float toneBlend = juce::jlimit(0.0f, 1.0f, drumTone);
-    const float toned = juce::jmap(toneBlend, v.toneState, out);
-
-    const float drumDriveGain = 1.0f + 6.6f * drumDrive;
-    const float drumDriven = softClip(toned * drumDriveGain) / std::sqrt(drumDriveGain);
-
-    return softClip(drumDriven * vel * drumLevel);
-}
-
-void BurialDrumPluginAudioProcessor::startTestSequence()
-{
-    testSequenceRequested.store(true);
-}
-
-void BurialDrumPluginAudioProcessor::queueDrumTestHit(DrumType type)
-{
-    const int drumIndex = drumTypeToIndex(type);
-    if (drumIndex < 0)
-        return;
+        const float level = voiceLevel(slot);
+        if (quietest < 0 || level < quietestLevel)
+        {
+            quietest = slot;
+            quietestLevel = level;
+        }
+    }
 
-    const auto bit = static_cast<uint32_t>(1u << static_cast<uint32_t>(drumIndex));
-    debugDrumTriggerMask.fetch_or(bit);
+    return quietest;
 }
 
-void BurialDrumPluginAudioProcessor::triggerTestSequenceEvents(int blockSize)
+int BurialDrumPluginAudioProcessor::allocateVoice()
 {
-    if (testSequenceRequested.exchange(false))
+    // Past the polyphony limit the quietest sounding voice fades out in the
+    // background to make room.
+    if (voicePool.numActive - voicePool.numFading >= polyphony)
+    {
+        if (const int stolen = findQuietestVoice(false); stolen >= 0)
+            voicePool.startFade(stolen, voiceFadeStep);
+    }
+
+    // With every spare slot still busy fading, the quietest fade is cut.
+    if (voicePool.numFree == 0)
     {
-        testSequencePlaying = true;
-        testSequenceSampleCursor = 0;
+        if (const int cut = findQuietestVoice(true); cut >= 0)
+        {
+            releaseVoiceCache(cut);
+            voicePool.release(cut);
+        }
     }
 
-    if (!testSequencePlaying)
+    return voicePool.allocate();
+}
+
+void BurialDrumPluginAudioProcessor::chokeVoices(DrumType type)
+{
+    const int drumIndex = drumTypeToIndex(type);
+    if (drumIndex < 0)
         return;
 
-    const int64_t samplesPerStep = static_cast<int64_t>(std::round((currentSampleRate * 60.0 / testSequenceBpm) * 0.25));
-    const int64_t totalSamples = samplesPerStep * testSequenceSteps;
-    const int64_t blockStart = testSequenceSampleCursor;
-    const int64_t blockEnd = blockStart + blockSize;
+    const int chokeGroup = blockDrumChokeGroups[static_cast<size_t>(drumIndex)];
+    int sounding = 0;
 
-    for (const auto& hit : testPattern)
+    for (int n = 0; n < voicePool.numActive; ++n)
     {
-        const int64_t hitSample = static_cast<int64_t>(hit.step) * samplesPerStep;
-        if (hitSample >= blockStart && hitSample < blockEnd)
-            triggerDrum(hit.type, hit.velocity, static_cast<int>(hitSample - blockStart));
+        const int slot = voicePool.activeVoices[static_cast<size_t>(n)];
+        if (voicePool.isFading(slot))
+            continue;
+
+        const int otherIndex = drumTypeToIndex(voicePool.type[static_cast<size_t>(slot)]);
+        if (otherIndex == drumIndex)
+            ++sounding;
+        else if (chokeGroup > 0 && otherIndex >= 0 && blockDrumChokeGroups[static_cast<size_t>(otherIndex)] == chokeGroup)
+            voicePool.startFade(slot, voiceFadeStep);
     }
 
-    testSequenceSampleCursor += blockSize;
-    if (testSequenceSampleCursor >= totalSamples)
-        testSequencePlaying = false;
+    // Keep the drum below its cap once the new hit starts.
+    for (; sounding >= blockDrumVoiceCaps[static_cast<size_t>(drumIndex)]; --sounding)
+        voicePool.startFade(findQuietestVoice(false, type), voiceFadeStep);
 }
 
-int BurialDrumPluginAudioProcessor::applySwingOffset(int sampleOffset, int blockSize) const
+void BurialDrumPluginAudioProcessor::triggerDrum(DrumType type, float velocity, int64_t sampleTime)
 {
-    const auto* swingParam = parameters.getRawParameterValue("swing");
-    if (swingParam == nullptr)
-        return sampleOffset;
+    chokeVoices(type);
 
-    const float swing = *swingParam;
-    if (swing <= 0.001f)
-        return sampleOffset;
+    const int slot = allocateVoice();
+    if (slot < 0)
+        return;
 
-    auto* playHead = getPlayHead();
-    if (playHead == nullptr)
-        return sampleOffset;
+    const auto i = static_cast<size_t>(slot);
+    voicePool.type[i] = type;
+    voicePool.velocity[i] = juce::jlimit(0.0f, 1.0f, velocity);
+    voicePool.sampleIndex[i] = 0;
+    voicePool.toneState[i] = 0.0f;
 
-    const auto position = playHead->getPosition();
-    if (!position.hasValue())
-        return sampleOffset;
+    const int drumIndex = drumTypeToIndex(type);
+    if (blockHitCacheEnabled && drumIndex >= 0)
+    {
+        startCachedHit(slot, drumIndex);
+        return;
+    }
 
-    const auto bpmOptional = position->getBpm();
-    const auto ppqOptional = position->getPpqPosition();
-    if (!bpmOptional.hasValue() || !ppqOptional.hasValue())
-        return sampleOffset;
+    voicePool.endSample[i] = voiceEndSample(slot);
 
-    const double bpm = *bpmOptional;
-    if (bpm <= 1.0)
-        return sampleOffset;
+    // Start phases and noise come from a stream keyed by the seed, the hit's
+    // time and drum, and its order among hits at that time, so identical
+    // input renders identically. While the host plays, the time is the hit's
+    // place on the host timeline, so a hit at a given song position sounds
+    // the same on every pass; otherwise it counts from prepareToPlay.
+    const int64_t hitTime = blockTiming.hasTimelinePosition
+                                ? blockTiming.timelineSampleAtStart + (sampleTime - blockStartSample)
+                                : sampleTime;
 
-    const double quartersPerSample = bpm / (60.0 * currentSampleRate);
-    const double ppqAtEvent = *ppqOptional + static_cast<double>(sampleOffset) * quartersPerSample;
-    const int eighthIndex = static_cast<int>(std::floor(ppqAtEvent * 2.0));
-    const bool isOffbeatEighth = (eighthIndex & 1) != 0;
+    hitsAtSameTime = hitTime == lastHitTime ? hitsAtSameTime + 1 : 0;
+    lastHitTime = hitTime;
 
-    if (!isOffbeatEighth)
+    drumdsp::CounterRng random;
+    random.key = drumdsp::splitMix64(blockSeed ^ drumdsp::splitMix64(static_cast<uint64_t>(hitTime)))
+               + static_cast<uint64_t>(drumIndex * 64 + hitsAtSameTime);
+
+    for (auto& partial : voicePool.partials)
+        partial[i].setPhase(random.nextFloat() * twoPi);
+    voicePool.noise[i].seed(static_cast<uint32_t>(random.next() >> 32));
+}
+
+void BurialDrumPluginAudioProcessor::startCachedHit(int slot, int drumIndex)
+{
+    const auto i = static_cast<size_t>(slot);
+    auto& variation = hitCacheNextVariation[static_cast<size_t>(drumIndex)];
+
+    HitCache::Key key;
+    key.drum = drumIndex;
+    key.velocityStep = juce::roundToInt(voicePool.velocity[i] * static_cast<float>(hitCacheVelocitySteps));
+    key.variant = variation;
+    variation = (variation + 1) % hitCacheVariations;
+
+    voicePool.velocity[i] = static_cast<float>(key.velocityStep) / static_cast<float>(hitCacheVelocitySteps);
+    voicePool.endSample[i] = voiceEndSample(slot);
+
+    // Phases and noise seed follow from the variation alone, so every hit
+    // with this key renders the same waveform whether or not it is cached.
+    const auto variationSeed = static_cast<uint32_t>(drumIndex * hitCacheVariations + key.variant) * 0x9e3779b9u;
+    for (size_t k = 0; k < voicePool.partials.size(); ++k)
+    {
+        const auto hash = drumdsp::hash32(variationSeed + static_cast<uint32_t>(k));
+        voicePool.partials[k][i].setPhase(static_cast<float>(hash >> 8) * (twoPi / 16777216.0f));
+    }
+    voicePool.noise[i].seed(drumdsp::hash32(variationSeed + 0x51ed27u));
+
+    if (const int entry = hitCache.acquire(key); entry >= 0)
+    {
+        voicePool.cacheEntry[i] = entry;
+        voicePool.cacheRecording[i] = false;
+        return;
+    }
+
+    // The first voice with a new key records it while playing; others that
+    // arrive before it finishes are synthesised as usual.
+    if (hitCache.isRecording(key))
+        return;
+
+    if (const int entry = hitCache.beginRecording(key, voicePool.endSample[i]); entry >= 0)
+    {
+        voicePool.cacheEntry[i] = entry;
+        voicePool.cacheRecording[i] = true;
+    }
+}
+
+void BurialDrumPluginAudioProcessor::releaseVoiceCache(int slot)
+{
+    const auto i = static_cast<size_t>(slot);
+    if (voicePool.cacheEntry[i] < 0)
+        return;
+
+    hitCache.release(voicePool.cacheEntry[i]);
+    voicePool.cacheEntry[i] = -1;
+    voicePool.cacheRecording[i] = false;
+}
+
+template <BurialDrumPluginAudioProcessor::DrumType type, typename SampleType, drumdsp::SoftClipMode clipMode>
+void BurialDrumPluginAudioProcessor::renderVoiceLanes(Voice* const* voices, const DrumBlockParams& p, float* dst, int numSamples)
+{
+    using Lanes = drumdsp::Lanes<SampleType>;
+    constexpr auto& model = drumModels[static_cast<size_t>(type)];
+
+    const float invSr = p.invSampleRate;
+    const float radiansPerHz = twoPi * p.tuneMul * invSr;
+
+    SampleType t, gain, toneState;
+    drumdsp::NoiseStreams* noiseStreams[Lanes::count];
+    drumdsp::NoiseBlock<SampleType, noiseChunkSamples * model.noisePerSample> noise;
+    drumdsp::PhasorBank<countPartials(model), SampleType> bank;
+    drumdsp::SweptPhasor<SampleType> sweptA, sweptB;
+
+    for (size_t lane = 0; lane < Lanes::count; ++lane)
+    {
+        Voice& v = *voices[lane];
+        noiseStreams[lane] = &v.noise;
+        Lanes::set(t, lane, static_cast<float>(v.sampleIndex) * invSr);
+        Lanes::set(gain, lane, (0.35f + 0.65f * v.velocity) * p.level);
+        Lanes::set(toneState, lane, v.toneState);
+        bank.setLane(lane, v.partials);
+        sweptA.osc.setLane(lane, v.partials[0]);
+        sweptB.osc.setLane(lane, v.partials[1]);
+    }
+
+    DrumEnvelopes<type, SampleType> env;
+    env.reset(t, p.decayMul, p.hatMul, invSr);
+
+    // Partials near or above Nyquist fade out through their weights below;
+    // the culled ones are not rotated at all.
+    bank.prepare({ model.partialHz[0] * radiansPerHz,
+                   model.partialHz[1] * radiansPerHz,
+                   model.partialHz[2] * radiansPerHz },
+                 numSamples, static_cast<size_t>(p.activePartials));
+    const auto& band = p.partialGain;
+
+    // Pitch-swept bodies: kick thump and sub an octave below, snare body.
+    if constexpr (type == DrumType::kick)
+    {
+        const SampleType startIncrement = (env.sweep.value * 300.0f + 46.0f) * radiansPerHz;
+        sweptA.prepare(startIncrement);
+        sweptB.prepare(startIncrement * 0.5f);
+    }
+    else if constexpr (type == DrumType::snare)
+    {
+        sweptA.prepare((env.sweep.value * 130.0f + 238.0f) * radiansPerHz);
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        if (i % noiseChunkSamples == 0)
+            noise.fill(noiseStreams, juce::jmin(noiseChunkSamples, numSamples - i) * model.noisePerSample, p.noiseGain);
+
+        SampleType out;
+
+        if constexpr (type == DrumType::kick)
+        {
+            const SampleType increment = (env.sweep.next() * 300.0f + 46.0f) * radiansPerHz;
+            const SampleType amp = env.amp.next();
+            const SampleType click = env.click.next() * noise.next();
+            const SampleType thump = sweptA.advance(increment) * amp;
+            const SampleType sub = sweptB.advance(increment * 0.5f) * env.sub.next();
+            out = (thump * 1.02f) + (sub * 0.60f) + click * 0.66f;
+        }
+        else if constexpr (type == DrumType::snare)
+        {
+            const SampleType bodyAmp = env.body.next();
+            const SampleType noiseAmp = env.noise.next();
+            const SampleType increment = (env.sweep.next() * 130.0f + 238.0f) * radiansPerHz;
+            const SampleType body = sweptA.advance(increment) * bodyAmp;
+            const SampleType n = noise.next() * noiseAmp;
+            const SampleType crack = env.crack.next() * noise.next();
+            out = body * 0.90f + n * 0.66f + crack * 0.94f;
+        }
+        else if constexpr (type == DrumType::closedHat)
+        {
+            const SampleType amp = env.amp.next();
+            const SampleType n = noise.next();
+            const SampleType metal = bank.sin(0) * band[0] + bank.sin(1) * band[1];
+            bank.advance();
+            out = (n * 0.62f + metal * 0.38f) * amp;
+        }
+        else if constexpr (type == DrumType::openHat)
+        {
+            const SampleType amp = env.amp.next();
+            const SampleType n = noise.next();
+            const SampleType metal = bank.sin(0) * band[0] + bank.sin(1) * (0.7f * band[1]) + bank.sin(2) * (0.4f * band[2]);
+            bank.advance();
+            out = (n * 0.42f + metal * 0.58f) * amp;
+        }
+        else if constexpr (type == DrumType::crash)
+        {
+            const SampleType amp = env.amp.next();
+            const SampleType n = noise.next() * env.noise.next();
+            bank.advance();
+            const SampleType partials = bank.sin(0) * (0.64f * band[0]) + bank.sin(1) * (0.38f * band[1]) + bank.sin(2) * (0.18f * band[2]);
+            out = (n * 0.22f + partials * 0.78f) * amp;
+        }
+        else if constexpr (type == DrumType::ride)
+        {
+            const SampleType amp = env.amp.next();
+            const SampleType n = noise.next() * env.noise.next();
+            bank.advance();
+            const SampleType ping = bank.sin(0) * band[0] * env.ping.next();
+            const SampleType tail = bank.sin(1) * (0.20f * band[1]) * env.tail.next();
+            out = (n * 0.20f + ping + tail) * amp;
+        }
+        else if constexpr (type == DrumType::clap)
+        {
+            out = noise.next() * env.amp.next();
+        }
+        else if constexpr (type == DrumType::rim)
+        {
+            const SampleType amp = env.amp.next();
+            bank.advance();
+            const SampleType tone = bank.sin(0) * band[0] + bank.sin(1) * (0.6f * band[1]);
+            const SampleType tick = env.tick.next() * noise.next();
+            out = (tone * 0.78f + tick * 0.50f) * amp;
+        }
+
+        toneState += (out - toneState) * p.toneCoeff;
+        const SampleType toned = toneState + (out - toneState) * p.toneBlend;
+        const SampleType driven = drumdsp::softClip<clipMode>(toned * p.driveGain) * p.driveTrim;
+
+        dst[i] += Lanes::sum(drumdsp::softClip<clipMode>(driven * gain));
+    }
+
+    for (size_t lane = 0; lane < Lanes::count; ++lane)
+    {
+        Voice& v = *voices[lane];
+        v.sampleIndex += numSamples;
+        v.toneState = Lanes::get(toneState, lane);
+        bank.getLane(lane, v.partials);
+
+        if constexpr (type == DrumType::kick)
+        {
+            v.partials[0] = sweptA.osc.getLane(lane);
+            v.partials[1] = sweptB.osc.getLane(lane);
+        }
+        else if constexpr (type == DrumType::snare)
+        {
+            v.partials[0] = sweptA.osc.getLane(lane);
+        }
+    }
+}
+
+template <BurialDrumPluginAudioProcessor::DrumType type, typename SampleType>
+void BurialDrumPluginAudioProcessor::renderVoiceLanes(drumdsp::SoftClipMode clipMode, Voice* const* voices,
+                                                      const DrumBlockParams& p, float* dst, int numSamples)
+{
+    switch (clipMode)
+    {
+        case drumdsp::SoftClipMode::exact: renderVoiceLanes<type, SampleType, drumdsp::SoftClipMode::exact>(voices, p, dst, numSamples); break;
+        case drumdsp::SoftClipMode::pade:  renderVoiceLanes<type, SampleType, drumdsp::SoftClipMode::pade>(voices, p, dst, numSamples); break;
+        case drumdsp::SoftClipMode::table: renderVoiceLanes<type, SampleType, drumdsp::SoftClipMode::table>(voices, p, dst, numSamples); break;
+    }
+}
+
+template <BurialDrumPluginAudioProcessor::DrumType type>
+void BurialDrumPluginAudioProcessor::renderVoiceKernel(Voice& v, const DrumBlockParams& p, float* dst, int numSamples)
+{
+    // A change of settings can move the end before the voice's position.
+    const int remaining = juce::jmax(0, v.endSample - v.sampleIndex);
+    const int count = juce::jmin(numSamples, remaining);
+
+    Voice* const voices[] = { &v };
+    if (count > 0)
+        renderVoiceLanes<type, float>(p.clipMode, voices, p, dst, count);
+
+    if (count >= remaining)
+        v.active = false;
+}
+
+const std::array<BurialDrumPluginAudioProcessor::VoiceKernel, BurialDrumPluginAudioProcessor::drumCount>
+    BurialDrumPluginAudioProcessor::voiceKernels {
+        &BurialDrumPluginAudioProcessor::renderVoiceKernel<DrumType::kick>,
+        &BurialDrumPluginAudioProcessor::renderVoiceKernel<DrumType::snare>,
+        &BurialDrumPluginAudioProcessor::renderVoiceKernel<DrumType::closedHat>,
+        &BurialDrumPluginAudioProcessor::renderVoiceKernel<DrumType::openHat>,
+        &BurialDrumPluginAudioProcessor::renderVoiceKernel<DrumType::crash>,
+        &BurialDrumPluginAudioProcessor::renderVoiceKernel<DrumType::ride>,
+        &BurialDrumPluginAudioProcessor::renderVoiceKernel<DrumType::clap>,
+        &BurialDrumPluginAudioProcessor::renderVoiceKernel<DrumType::rim>
+    };
+
+#if JUCE_USE_SIMD
+template <BurialDrumPluginAudioProcessor::DrumType type>
+void BurialDrumPluginAudioProcessor::renderVoiceGroupKernel(Voice* voices, const DrumBlockParams& p, float* dst, int numSamples)
+{
+    std::array<int, voiceGroupSize> remaining {};
+    std::array<Voice*, voiceGroupSize> lanes {};
+    int shared = numSamples;
+
+    for (size_t lane = 0; lane < lanes.size(); ++lane)
+    {
+        lanes[lane] = voices + lane;
+        remaining[lane] = juce::jmax(0, voices[lane].endSample - voices[lane].sampleIndex);
+        shared = juce::jmin(shared, remaining[lane]);
+    }
+
+    // All lanes run together until the first one falls silent; any
+    // voice that outlives it finishes the block on the scalar kernel.
+    if (shared > 0)
+        renderVoiceLanes<type, drumdsp::FloatVec>(p.clipMode, lanes.data(), p, dst, shared);
+
+    for (size_t lane = 0; lane < lanes.size(); ++lane)
+    {
+        if (shared >= remaining[lane])
+            voices[lane].active = false;
+        else if (shared < numSamples)
+            renderVoiceKernel<type>(voices[lane], p, dst + shared, numSamples - shared);
+    }
+}
+
+const std::array<BurialDrumPluginAudioProcessor::VoiceGroupKernel, BurialDrumPluginAudioProcessor::drumCount>
+    BurialDrumPluginAudioProcessor::voiceGroupKernels {
+        &BurialDrumPluginAudioProcessor::renderVoiceGroupKernel<DrumType::kick>,
+        &BurialDrumPluginAudioProcessor::renderVoiceGroupKernel<DrumType::snare>,
+        &BurialDrumPluginAudioProcessor::renderVoiceGroupKernel<DrumType::closedHat>,
+        &BurialDrumPluginAudioProcessor::renderVoiceGroupKernel<DrumType::openHat>,
+        &BurialDrumPluginAudioProcessor::renderVoiceGroupKernel<DrumType::crash>,
+        &BurialDrumPluginAudioProcessor::renderVoiceGroupKernel<DrumType::ride>,
+        &BurialDrumPluginAudioProcessor::renderVoiceGroupKernel<DrumType::clap>,
+        &BurialDrumPluginAudioProcessor::renderVoiceGroupKernel<DrumType::rim>
+    };
+#endif
+
+void BurialDrumPluginAudioProcessor::setSmootherTargets()
+{
+    tuneSmoother.setTargetValue(*parameters.getRawParameterValue("tune"));
+    decaySmoother.setTargetValue(*parameters.getRawParameterValue("decay"));
+    toneSmoother.setTargetValue(*parameters.getRawParameterValue("tone"));
+    driveSmoother.setTargetValue(*parameters.getRawParameterValue("drive"));
+    hatLengthSmoother.setTargetValue(*parameters.getRawParameterValue("hatLength"));
+
+    for (size_t i = 0; i < drumCount; ++i)
+    {
+        if (drumLevelParams[i] != nullptr)
+            drumLevelSmoothers[i].setTargetValue(*drumLevelParams[i]);
+        if (drumTuneParams[i] != nullptr)
+            drumTuneSmoothers[i].setTargetValue(*drumTuneParams[i]);
+        if (drumDecayParams[i] != nullptr)
+            drumDecaySmoothers[i].setTargetValue(*drumDecayParams[i]);
+        if (drumToneParams[i] != nullptr)
+            drumToneSmoothers[i].setTargetValue(*drumToneParams[i]);
+        if (drumDriveParams[i] != nullptr)
+            drumDriveSmoothers[i].setTargetValue(*drumDriveParams[i]);
+    }
+}
+
+bool BurialDrumPluginAudioProcessor::isVoiceParamSmoothing() const
+{
+    if (tuneSmoother.isSmoothing() || decaySmoother.isSmoothing() || hatLengthSmoother.isSmoothing())
+        return true;
+
+    for (size_t i = 0; i < drumCount; ++i)
+    {
+        if (drumLevelSmoothers[i].isSmoothing() || drumTuneSmoothers[i].isSmoothing() || drumDecaySmoothers[i].isSmoothing()
+            || drumToneSmoothers[i].isSmoothing() || drumDriveSmoothers[i].isSmoothing())
+            return true;
+    }
+
+    return false;
+}
+
+void BurialDrumPluginAudioProcessor::advanceVoiceParams(int numSamples)
+{
+    // A smoother at rest returns its target, so a static drum recomputes to
+    // the same parameters and keeps its cached hits.
+    blockTuneSemitones = tuneSmoother.skip(numSamples);
+    blockDecay = decaySmoother.skip(numSamples);
+    blockHatLength = hatLengthSmoother.skip(numSamples);
+
+    for (size_t i = 0; i < drumCount; ++i)
+    {
+        blockDrumLevels[i] = drumLevelSmoothers[i].skip(numSamples);
+        blockDrumTuneSemitones[i] = drumTuneSmoothers[i].skip(numSamples);
+        blockDrumDecay[i] = drumDecaySmoothers[i].skip(numSamples);
+        blockDrumTone[i] = drumToneSmoothers[i].skip(numSamples);
+        blockDrumDrive[i] = drumDriveSmoothers[i].skip(numSamples);
+    }
+
+    updateDrumBlockParams();
+}
+
+void BurialDrumPluginAudioProcessor::updateDrumBlockParams()
+{
+    const float invSampleRate = static_cast<float>(1.0 / renderSampleRate);
+    const auto factor = static_cast<float>(oversamplingFactor);
+    const auto nyquistHz = static_cast<float>(currentSampleRate * 0.5);
+    const float bandLimitHz = nyquistHz * partialBandLimit;
+
+    for (size_t i = 0; i < drumCount; ++i)
+    {
+        DrumBlockParams p;
+        p.invSampleRate = invSampleRate;
+        p.tuneMul = std::pow(2.0f, (blockTuneSemitones + blockDrumTuneSemitones[i]) / 12.0f);
+        p.decayMul = blockDecay * blockDrumDecay[i];
+        p.hatMul = blockHatLength;
+        p.level = blockDrumLevels[i];
+        p.toneCoeff = juce::jmap(blockDrumTone[i], 0.02f, 0.62f);
+
+        // Oversampled, the tone filter keeps its cutoff and white noise its
+        // level within the host band.
+        if (oversamplingFactor > 1)
+        {
+            p.toneCoeff = 1.0f - std::pow(1.0f - p.toneCoeff, 1.0f / factor);
+            p.noiseGain = std::sqrt(factor);
+        }
+
+        p.toneBlend = juce::jlimit(0.0f, 1.0f, blockDrumTone[i]);
+        p.driveGain = 1.0f + 6.6f * blockDrumDrive[i];
+        p.driveTrim = 1.0f / std::sqrt(p.driveGain);
+        p.clipMode = blockClipMode;
+        p.retireLevel = blockRetireLevel;
+
+        // Partials tuned into the top of the host band fade out, and those
+        // at or past Nyquist are culled: they would only alias, or be
+        // filtered away again when oversampled. Each model lists its
+        // partials in rising order, so the culled ones are always the last.
+        const auto& model = drumModels[i];
+        p.activePartials = 0;
+        for (size_t k = 0; k < countPartials(model); ++k)
+        {
+            const float hz = model.partialHz[k] * p.tuneMul;
+            p.partialGain[k] = juce::jlimit(0.0f, 1.0f, (nyquistHz - hz) / (nyquistHz - bandLimitHz));
+            if (p.partialGain[k] > 0.0f)
+                p.activePartials = static_cast<int>(k) + 1;
+        }
+
+        // Cached hits were rendered with the old settings.
+        if (p != drumBlockParams[i])
+        {
+            hitCache.invalidateDrum(static_cast<int>(i));
+            drumBlockParamsChanged[i] = true;
+        }
+
+        drumBlockParams[i] = p;
+    }
+}
+
+void BurialDrumPluginAudioProcessor::updateVoiceRetirement()
+{
+    // Sounding voices move their retirement point to the new settings, and
+    // the tail reported to the host follows the longest full-velocity hit.
+    // During a ramp this runs once per block rather than per sub-block.
+    auto& changed = drumBlockParamsChanged;
+    if (std::none_of(changed.begin(), changed.end(), [](bool drumChanged) { return drumChanged; }))
+        return;
+
+    for (int n = 0; n < voicePool.numActive; ++n)
+    {
+        const int slot = voicePool.activeVoices[static_cast<size_t>(n)];
+        const int drumIndex = drumTypeToIndex(voicePool.type[static_cast<size_t>(slot)]);
+
+        if (drumIndex >= 0 && changed[static_cast<size_t>(drumIndex)])
+            voicePool.endSample[static_cast<size_t>(slot)] = voiceEndSample(slot);
+    }
+
+    int tailSamples = 0;
+    for (size_t i = 0; i < drumCount; ++i)
+    {
+        const auto& p = drumBlockParams[i];
+        tailSamples = juce::jmax(tailSamples, samplesUntilSilent(static_cast<DrumType>(i), p.level * p.driveGain * p.driveTrim,
+                                                                 p.retireLevel, p.decayMul, p.hatMul, p.invSampleRate));
+    }
+
+    tailLengthSeconds.store(static_cast<double>(tailSamples) / renderSampleRate);
+    changed.fill(false);
+}
+
+void BurialDrumPluginAudioProcessor::updatePartialCounts()
+{
+    std::array<int, drumCount> voicesPerDrum {};
+    for (int n = 0; n < voicePool.numActive; ++n)
+    {
+        const int drumIndex = drumTypeToIndex(voicePool.type[static_cast<size_t>(voicePool.activeVoices[static_cast<size_t>(n)])]);
+        if (drumIndex >= 0)
+            ++voicesPerDrum[static_cast<size_t>(drumIndex)];
+    }
+
+    int sounding = 0;
+    int culled = 0;
+    for (size_t i = 0; i < drumCount; ++i)
+    {
+        const int active = drumBlockParams[i].activePartials;
+        sounding += voicesPerDrum[i] * active;
+        culled += voicesPerDrum[i] * (static_cast<int>(countPartials(drumModels[i])) - active);
+    }
+
+    soundingPartials.store(sounding);
+    culledPartials.store(culled);
+}
+
+int BurialDrumPluginAudioProcessor::renderVoiceBlock(int slot, float* dst, int numSamples)
+{
+    const int drumIndex = drumTypeToIndex(voicePool.type[static_cast<size_t>(slot)]);
+    if (drumIndex < 0)
+    {
+        voicePool.release(slot);
+        return 0;
+    }
+
+    // The voice state is copied to a local for the whole span so it stays in
+    // registers, and the drum's kernel is chosen once rather than per sample.
+    Voice local = voicePool.load(slot);
+    const int indexBefore = local.sampleIndex;
+    voiceKernels[static_cast<size_t>(drumIndex)](local, drumBlockParams[static_cast<size_t>(drumIndex)], dst, numSamples);
+    voicePool.store(slot, local);
+
+    if (!local.active)
+        voicePool.release(slot);
+
+    return local.sampleIndex - indexBefore;
+}
+
+int BurialDrumPluginAudioProcessor::renderFadingVoiceBlock(int slot, float* dst, int numSamples)
+{
+    const auto i = static_cast<size_t>(slot);
+    float gain = voicePool.fadeGain[i];
+    const float step = voicePool.fadeStep[i];
+    const int fadeRemaining = static_cast<int>(std::ceil(gain / step));
+    const int count = juce::jmin(numSamples, fadeRemaining);
+
+    // Rendered to scratch first so the kernels stay free of a fade multiply.
+    auto* scratch = mixBuffer.getWritePointer(1);
+    juce::FloatVectorOperations::clear(scratch, count);
+
+    const int rendered = voicePool.cacheEntry[i] >= 0 ? renderCachedVoiceBlock(slot, scratch, count)
+                                                      : renderVoiceBlock(slot, scratch, count);
+
+    for (int n = 0; n < rendered; ++n)
+    {
+        dst[n] += scratch[n] * juce::jmax(0.0f, gain);
+        gain -= step;
+    }
+
+    if (voicePool.isActive(slot))
+    {
+        voicePool.fadeGain[i] = gain;
+
+        if (count >= fadeRemaining)
+        {
+            releaseVoiceCache(slot);
+            voicePool.release(slot);
+        }
+    }
+
+    return rendered;
+}
+
+int BurialDrumPluginAudioProcessor::renderCachedVoiceBlock(int slot, float* dst, int numSamples)
+{
+    const auto i = static_cast<size_t>(slot);
+    const int entry = voicePool.cacheEntry[i];
+    int rendered = 0;
+
+    if (voicePool.cacheRecording[i])
+    {
+        if (!hitCache.isValid(entry))
+        {
+            releaseVoiceCache(slot);
+            return renderVoiceBlock(slot, dst, numSamples);
+        }
+
+        // Synthesise straight into the entry's zeroed pages, then mix from there.
+        const int drumIndex = drumTypeToIndex(voicePool.type[i]);
+        const auto& params = drumBlockParams[static_cast<size_t>(drumIndex)];
+        Voice local = voicePool.load(slot);
+
+        while (rendered < numSamples && local.active)
+        {
+            int available = 0;
+            auto* recorded = hitCache.getPointer(entry, local.sampleIndex, available);
+            if (available <= 0)
+                break;
+
+            const int indexBefore = local.sampleIndex;
+            voiceKernels[static_cast<size_t>(drumIndex)](local, params, recorded, juce::jmin(available, numSamples - rendered));
+
+            const int count = local.sampleIndex - indexBefore;
+            juce::FloatVectorOperations::add(dst + rendered, recorded, count);
+            rendered += count;
+        }
+
+        voicePool.store(slot, local);
+
+        if (local.active && local.sampleIndex < hitCache.getLength(entry))
+            return rendered;
+
+        hitCache.finishRecording(entry);
+    }
+    else
+    {
+        auto& sampleIndex = voicePool.sampleIndex[i];
+        const int length = hitCache.getLength(entry);
+
+        while (rendered < numSamples && sampleIndex < length)
+        {
+            int available = 0;
+            const auto* cached = hitCache.getPointer(entry, sampleIndex, available);
+            const int count = juce::jmin(available, numSamples - rendered);
+
+            juce::FloatVectorOperations::add(dst + rendered, cached, count);
+            rendered += count;
+            sampleIndex += count;
+        }
+
+        if (sampleIndex < length)
+            return rendered;
+    }
+
+    releaseVoiceCache(slot);
+    voicePool.release(slot);
+    return rendered;
+}
+
+#if JUCE_USE_SIMD
+int BurialDrumPluginAudioProcessor::renderVoiceGroup(const int* slots, int drumIndex, float* dst, int numSamples)
+{
+    std::array<Voice, voiceGroupSize> group;
+    std::array<int, voiceGroupSize> indexBefore {};
+
+    for (size_t lane = 0; lane < group.size(); ++lane)
+    {
+        group[lane] = voicePool.load(slots[lane]);
+        indexBefore[lane] = group[lane].sampleIndex;
+    }
+
+    voiceGroupKernels[static_cast<size_t>(drumIndex)](group.data(), drumBlockParams[static_cast<size_t>(drumIndex)], dst, numSamples);
+
+    int rendered = 0;
+    for (size_t lane = 0; lane < group.size(); ++lane)
+    {
+        voicePool.store(slots[lane], group[lane]);
+        rendered = juce::jmax(rendered, group[lane].sampleIndex - indexBefore[lane]);
+
+        if (!group[lane].active)
+            voicePool.release(slots[lane]);
+    }
+
+    return rendered;
+}
+#endif
+
+int BurialDrumPluginAudioProcessor::renderActiveVoices(const DrumOutputs& dst, int numSamples, std::array<int, drumCount>& drumRendered)
+{
+    // Voices are bucketed by drum so that same-type voices can be rendered
+    // side by side in SIMD lanes; cached hits and fading voices are mixed
+    // back on their own. Every voice renders once, into its drum's output.
+    std::array<std::array<int, maxVoices>, drumCount> drumGroups;
+    std::array<int, drumCount> drumGroupSizes {};
+    drumRendered.fill(0);
+
+    // Walk the active list backwards so voices released during rendering
+    // (swap-removed from the list) never cause a slot to be skipped.
+    for (int i = voicePool.numActive; --i >= 0;)
+    {
+        const int slot = voicePool.activeVoices[static_cast<size_t>(i)];
+        const int drumIndex = drumTypeToIndex(voicePool.type[static_cast<size_t>(slot)]);
+        if (drumIndex < 0)
+        {
+            voicePool.release(slot);
+            continue;
+        }
+
+        const auto drum = static_cast<size_t>(drumIndex);
+
+        if (voicePool.isFading(slot))
+        {
+            drumRendered[drum] = juce::jmax(drumRendered[drum], renderFadingVoiceBlock(slot, dst[drum], numSamples));
+            continue;
+        }
+
+        if (voicePool.cacheEntry[static_cast<size_t>(slot)] >= 0)
+        {
+            drumRendered[drum] = juce::jmax(drumRendered[drum], renderCachedVoiceBlock(slot, dst[drum], numSamples));
+            continue;
+        }
+
+        // A voice whose end a change of settings moved behind it is retired
+        // here, so it never holds its group to a zero-length span.
+        if (voicePool.sampleIndex[static_cast<size_t>(slot)] >= voicePool.endSample[static_cast<size_t>(slot)])
+        {
+            voicePool.release(slot);
+            continue;
+        }
+
+        auto& size = drumGroupSizes[drum];
+        drumGroups[drum][static_cast<size_t>(size++)] = slot;
+    }
+
+    int rendered = 0;
+    for (size_t drum = 0; drum < drumCount; ++drum)
+    {
+        const auto& slots = drumGroups[drum];
+        const int size = drumGroupSizes[drum];
+        int next = 0;
+
+       #if JUCE_USE_SIMD
+        for (; next + voiceGroupSize <= size; next += voiceGroupSize)
+            drumRendered[drum] = juce::jmax(drumRendered[drum], renderVoiceGroup(slots.data() + next, static_cast<int>(drum), dst[drum], numSamples));
+       #endif
+
+        for (; next < size; ++next)
+            drumRendered[drum] = juce::jmax(drumRendered[drum], renderVoiceBlock(slots[static_cast<size_t>(next)], dst[drum], numSamples));
+
+        rendered = juce::jmax(rendered, drumRendered[drum]);
+    }
+
+    return rendered;
+}
+
+void BurialDrumPluginAudioProcessor::queueHit(DrumType type, float velocity, int64_t sampleTime)
+{
+    // A full queue drops the hit rather than allocate on the audio thread.
+    pendingHits.push(sampleTime, { type, velocity });
+}
+
+bool BurialDrumPluginAudioProcessor::startSequencer(bool loop)
+{
+    Command command;
+    command.type = Command::Type::startSequence;
+    command.value = loop ? 1 : 0;
+    return pushCommand(command);
+}
+
+bool BurialDrumPluginAudioProcessor::stopSequencer()
+{
+    Command command;
+    command.type = Command::Type::stopSequence;
+    return pushCommand(command);
+}
+
+bool BurialDrumPluginAudioProcessor::queueDrumTestHit(DrumType type, float velocity)
+{
+    if (drumTypeToIndex(type) < 0)
+        return false;
+
+    Command command;
+    command.type = Command::Type::trigger;
+    command.drum = type;
+    command.velocity = velocity;
+    return pushCommand(command);
+}
+
+bool BurialDrumPluginAudioProcessor::notifyPresetLoaded()
+{
+    Command command;
+    command.type = Command::Type::presetLoaded;
+    return pushCommand(command);
+}
+
+bool BurialDrumPluginAudioProcessor::setUserGroove(const GrooveTemplate& delays)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    juce::StringArray values;
+    for (const auto delay : delays)
+        values.add(juce::String(delay));
+
+    parameters.state.setProperty("userGroove", values.joinIntoString(" "), nullptr);
+    queueUserGroove(delays);
+    return true;
+}
+
+void BurialDrumPluginAudioProcessor::queueUserGroove(const GrooveTemplate& delays)
+{
+    const juce::SpinLock::ScopedLockType lock(userGrooveLock);
+    pendingUserGroove = delays;
+    userGroovePending = true;
+}
+
+void BurialDrumPluginAudioProcessor::takePendingUserGroove()
+{
+    // A groove being written right now is picked up next block.
+    const juce::SpinLock::ScopedTryLockType lock(userGrooveLock);
+    if (lock.isLocked() && userGroovePending)
+    {
+        userGroove = pendingUserGroove;
+        userGroovePending = false;
+    }
+}
+
+bool BurialDrumPluginAudioProcessor::setSequencerStep(int pattern, int step, DrumType type, float velocity)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    const int drumIndex = drumTypeToIndex(type);
+    if (pattern < 0 || pattern >= StepSequencer::maxPatterns || drumIndex < 0)
+        return false;
+
+    if (!sequencerEdits.patterns[static_cast<size_t>(pattern)].setHit(step, drumIndex, velocity))
+        return false;
+
+    publishSequencer();
+    return true;
+}
+
+bool BurialDrumPluginAudioProcessor::setSequencerPatternLength(int pattern, int numSteps)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (pattern < 0 || pattern >= StepSequencer::maxPatterns)
+        return false;
+
+    sequencerEdits.patterns[static_cast<size_t>(pattern)].setLength(numSteps);
+    publishSequencer();
+    return true;
+}
+
+bool BurialDrumPluginAudioProcessor::setSequencerChain(const int* patterns, int length)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (!sequencerEdits.setChain(patterns, length))
+        return false;
+
+    publishSequencer();
+    return true;
+}
+
+float BurialDrumPluginAudioProcessor::getSequencerStep(int pattern, int step, DrumType type) const
+{
+    const int drumIndex = drumTypeToIndex(type);
+    if (pattern < 0 || pattern >= StepSequencer::maxPatterns || drumIndex < 0)
+        return 0.0f;
+
+    return sequencerEdits.patterns[static_cast<size_t>(pattern)].getVelocity(step, drumIndex);
+}
+
+int BurialDrumPluginAudioProcessor::getSequencerPatternLength(int pattern) const
+{
+    if (pattern < 0 || pattern >= StepSequencer::maxPatterns)
+        return 0;
+
+    return sequencerEdits.patterns[static_cast<size_t>(pattern)].numSteps;
+}
+
+juce::Array<int> BurialDrumPluginAudioProcessor::getSequencerChain() const
+{
+    juce::Array<int> chain;
+    for (int i = 0; i < sequencerEdits.chainLength; ++i)
+        chain.add(sequencerEdits.chain[static_cast<size_t>(i)]);
+
+    return chain;
+}
+
+void BurialDrumPluginAudioProcessor::publishSequencer()
+{
+    // Saved as "steps" and "step:drum:velocity" hits per pattern, alongside
+    // the user groove.
+    juce::ValueTree tree("Sequencer");
+
+    juce::StringArray chain;
+    for (int i = 0; i < sequencerEdits.chainLength; ++i)
+        chain.add(juce::String(sequencerEdits.chain[static_cast<size_t>(i)]));
+
+    tree.setProperty("chain", chain.joinIntoString(" "), nullptr);
+
+    for (const auto& pattern : sequencerEdits.patterns)
+    {
+        juce::StringArray hits;
+        for (int i = 0; i < pattern.numHits; ++i)
+        {
+            const auto& hit = pattern.hits[static_cast<size_t>(i)];
+            hits.add(juce::String(hit.step) + ":" + juce::String(hit.drum) + ":" + juce::String(hit.velocity));
+        }
+
+        juce::ValueTree child("Pattern");
+        child.setProperty("steps", pattern.numSteps, nullptr);
+        child.setProperty("hits", hits.joinIntoString(" "), nullptr);
+        tree.appendChild(child, nullptr);
+    }
+
+    if (const auto old = parameters.state.getChildWithName("Sequencer"); old.isValid())
+        parameters.state.removeChild(old, nullptr);
+
+    parameters.state.appendChild(tree, nullptr);
+    sequencer.publish(sequencerEdits);
+    ++sequencerChanges;
+}
+
+void BurialDrumPluginAudioProcessor::resetSequencerEdits()
+{
+    // Empty 16-step patterns, except pattern 1, which starts out as the test
+    // groove; the chain plays pattern 1 alone.
+    for (auto& pattern : sequencerEdits.patterns)
+    {
+        pattern.clear();
+        pattern.setLength(16);
+    }
+
+    auto& first = sequencerEdits.patterns[0];
+    first.setLength(testSequenceSteps);
+    for (const auto& hit : testPattern)
+        first.setHit(hit.step, drumTypeToIndex(hit.type), hit.velocity);
+
+    const int firstPattern = 0;
+    sequencerEdits.setChain(&firstPattern, 1);
+}
+
+void BurialDrumPluginAudioProcessor::loadSequencerState(const juce::ValueTree& tree)
+{
+    // The restored state already holds tree, so only the edit bank and the
+    // audio thread's copy are updated. A state saved without a sequencer
+    // gets the default bank back.
+    if (!tree.isValid())
+    {
+        resetSequencerEdits();
+        sequencer.publish(sequencerEdits);
+        ++sequencerChanges;
+        return;
+    }
+
+    // The edit bank is rebuilt in place; a Bank is too large for the stack.
+    auto& bank = sequencerEdits;
+    for (auto& pattern : bank.patterns)
+    {
+        pattern.clear();
+        pattern.setLength(16);
+    }
+
+    const int firstPattern = 0;
+    bank.setChain(&firstPattern, 1);
+
+    for (int p = 0; p < juce::jmin(tree.getNumChildren(), StepSequencer::maxPatterns); ++p)
+    {
+        const auto child = tree.getChild(p);
+        auto& pattern = bank.patterns[static_cast<size_t>(p)];
+        pattern.setLength(child.getProperty("steps", 16));
+
+        for (const auto& token : juce::StringArray::fromTokens(child.getProperty("hits").toString(), " ", ""))
+        {
+            const auto fields = juce::StringArray::fromTokens(token, ":", "");
+            if (fields.size() == 3 && juce::isPositiveAndBelow(fields[1].getIntValue(), drumCount))
+                pattern.setHit(fields[0].getIntValue(), fields[1].getIntValue(), fields[2].getFloatValue());
+        }
+    }
+
+    std::array<int, StepSequencer::maxChainLength> chain {};
+    const auto values = juce::StringArray::fromTokens(tree.getProperty("chain").toString(), " ", "");
+    const int length = juce::jmin(values.size(), StepSequencer::maxChainLength);
+    for (int i = 0; i < length; ++i)
+        chain[static_cast<size_t>(i)] = values[i].getIntValue();
+
+    bank.setChain(chain.data(), length);
+    sequencer.publish(sequencerEdits);
+    ++sequencerChanges;
+}
+
+bool BurialDrumPluginAudioProcessor::pushCommand(const Command& command)
+{
+    const auto scope = commandFifo.write(1);
+    if (scope.blockSize1 + scope.blockSize2 == 0)
+        return false;
+
+    auto& slot = commands[static_cast<size_t>(scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)];
+    slot = command;
+    slot.timeMs = juce::Time::getMillisecondCounterHiRes();
+    return true;
+}
+
+void BurialDrumPluginAudioProcessor::drainCommands(int numSamples)
+{
+    const int numReady = commandFifo.getNumReady();
+    if (numReady == 0)
+        return;
+
+    // Triggers keep the spacing they were sent with: each lands in this block
+    // as far before its end as it was sent before now, so hits within one
+    // block are never collapsed, at a fixed latency of up to one block.
+    const double nowMs = juce::Time::getMillisecondCounterHiRes();
+    const double samplesPerMs = currentSampleRate * 0.001;
+
+    const auto scope = commandFifo.read(numReady);
+    auto handle = [&](int start, int count)
+    {
+        for (int n = start; n < start + count; ++n)
+        {
+            const auto& command = commands[static_cast<size_t>(n)];
+
+            switch (command.type)
+            {
+                case Command::Type::trigger:
+                {
+                    const auto age = static_cast<int>((nowMs - command.timeMs) * samplesPerMs);
+                    const int offset = juce::jlimit(0, juce::jmax(0, numSamples - 1), numSamples - 1 - age);
+                    queueHit(command.drum, command.velocity, blockStartSample + offset);
+                    break;
+                }
+
+                case Command::Type::startSequence:
+                    sequencer.start(command.value != 0);
+                    break;
+
+                case Command::Type::stopSequence:
+                    sequencer.stop();
+                    break;
+
+                case Command::Type::presetLoaded:
+                    // Tails of the old kit fade rather than carry on with the new settings.
+                    for (int v = 0; v < voicePool.numActive; ++v)
+                        voicePool.startFade(voicePool.activeVoices[static_cast<size_t>(v)], voiceFadeStep);
+                    break;
+            }
+        }
+    };
+
+    handle(scope.startIndex1, scope.blockSize1);
+    handle(scope.startIndex2, scope.blockSize2);
+}
+
+void BurialDrumPluginAudioProcessor::applyPolyphony(int numVoices)
+{
+    // Storage is fixed at the maximum, so this only moves the limit; voices
+    // over a lowered limit are stolen as new hits arrive.
+    polyphony = juce::jlimit(minPolyphony, maxPolyphony, numVoices);
+    voicePool.setNumSlots(polyphony + maxFadingVoices);
+}
+
+void BurialDrumPluginAudioProcessor::triggerSequencerEvents(int numSamples)
+{
+    sequencer.beginBlock();
+
+    // The sequencer follows the host's tempo, and its position too while the
+    // transport runs; otherwise it keeps its own default tempo.
+    const auto& timing = blockTiming;
+    const double bpm = timing.hasTempo ? timing.bpm : testSequenceBpm;
+    const double samplesPerStep = currentSampleRate * 60.0 / (bpm * StepSequencer::stepsPerBeat);
+    const bool hostPlaying = timing.hasTempo && timing.isPlaying;
+
+    // With Sequencer Follows Host on, the chain loops while the transport
+    // runs and stops with it.
+    const bool followHost = sequencerFollowParam != nullptr && sequencerFollowParam->load() > 0.5f;
+    if (followHost && hostPlaying && !sequencerStartedByHost)
+    {
+        sequencer.start(true);
+        sequencerStartedByHost = true;
+    }
+    else if (sequencerStartedByHost && !(followHost && hostPlaying))
+    {
+        sequencer.stop();
+        sequencerStartedByHost = false;
+    }
+
+    if (sequencer.isPlaying() && hostPlaying)
+        sequencer.syncTo(timing.ppqAtStart * StepSequencer::stepsPerBeat);
+
+    sequencer.process(numSamples, samplesPerStep, [this](int offset, int drum, float velocity)
+    {
+        queueHit(static_cast<DrumType>(drum), velocity, blockStartSample + applyGrooveOffset(offset));
+    });
+}
+
+void BurialDrumPluginAudioProcessor::updateBlockTiming()
+{
+    auto& timing = blockTiming;
+    timing.hasTempo = false;
+    timing.isPlaying = false;
+    timing.hasTimelinePosition = false;
+    timing.hasGroove = false;
+
+    if (auto* hostPlayHead = getPlayHead())
+    {
+        if (const auto position = hostPlayHead->getPosition(); position.hasValue())
+        {
+            const auto bpm = position->getBpm();
+            const auto ppq = position->getPpqPosition();
+
+            if (bpm.hasValue() && ppq.hasValue() && *bpm > 1.0)
+            {
+                timing.hasTempo = true;
+                timing.bpm = *bpm;
+                timing.ppqAtStart = *ppq;
+                timing.ppqPerSample = *bpm / (60.0 * currentSampleRate);
+                timing.barStartPpq = position->getPpqPositionOfLastBarStart().orFallback(0.0);
+            }
+
+            timing.isPlaying = position->getIsPlaying();
+
+            if (const auto timeInSamples = position->getTimeInSamples(); timing.isPlaying && timeInSamples.hasValue())
+            {
+                timing.hasTimelinePosition = true;
+                timing.timelineSampleAtStart = *timeInSamples;
+            }
+            else if (timing.isPlaying && timing.hasTempo)
+            {
+                timing.hasTimelinePosition = true;
+                timing.timelineSampleAtStart = static_cast<int64_t>(std::llround(timing.ppqAtStart / timing.ppqPerSample));
+            }
+        }
+    }
+
+    if (!timing.hasTempo)
+        return;
+
+    const float swing = swingParam != nullptr ? swingParam->load() : 0.0f;
+    const bool swingSixteenths = swingDivisionParam != nullptr && swingDivisionParam->load() > 0.5f;
+    const int grooveIndex = grooveParam != nullptr ? juce::roundToInt(grooveParam->load()) : 0;
+
+    const GrooveTemplate* groove = nullptr;
+    if (grooveIndex > 0 && grooveIndex <= static_cast<int>(grooveTemplates.size()))
+        groove = &grooveTemplates[static_cast<size_t>(grooveIndex - 1)];
+    else if (grooveIndex == static_cast<int>(grooveTemplates.size()) + 1)
+        groove = &userGroove;
+
+    if (swing <= 0.001f && groove == nullptr)
+        return;
+
+    // Swing delays the off-beat 8ths (the second half of each beat) or the
+    // off-beat 16ths by up to a third of that division.
+    const double samplesPerBeat = (60.0 / timing.bpm) * currentSampleRate;
+    const int divisionSamples = static_cast<int>(std::round(samplesPerBeat * (swingSixteenths ? 0.25 : 0.5)));
+    const int maxSwingSamples = static_cast<int>(std::round(divisionSamples * 0.33));
+    const int swingDelay = swing > 0.001f ? static_cast<int>(std::round(static_cast<float>(maxSwingSamples) * swing)) : 0;
+
+    for (int step = 0; step < grooveSteps; ++step)
+    {
+        const bool isOffbeat = swingSixteenths ? (step & 1) != 0 : (step & 3) >= 2;
+        int delay = isOffbeat ? swingDelay : 0;
+
+        if (groove != nullptr)
+        {
+            const float fraction = juce::jlimit(0.0f, maxGrooveDelay, (*groove)[static_cast<size_t>(step)]);
+            delay += static_cast<int>(std::round(static_cast<double>(fraction) * samplesPerBeat * 0.25));
+        }
+
+        timing.stepDelays[static_cast<size_t>(step)] = delay;
+    }
+
+    timing.hasGroove = true;
+}
+
+int BurialDrumPluginAudioProcessor::applyGrooveOffset(int sampleOffset) const
+{
+    const auto& timing = blockTiming;
+    if (!timing.hasGroove)
         return sampleOffset;
 
-    const int samplesPerEighth = static_cast<int>(std::round((60.0 / bpm) * currentSampleRate * 0.5));
-    const int maxSwingSamples = static_cast<int>(std::round(samplesPerEighth * 0.33));
-    const int delay = static_cast<int>(std::round(static_cast<float>(maxSwingSamples) * swing));
-    return juce::jlimit(0, blockSize + maxSwingSamples, sampleOffset + delay);
+    const double ppqAtEvent = timing.ppqAtStart + static_cast<double>(sampleOffset) * timing.ppqPerSample;
+    const auto sixteenth = static_cast<int64_t>(std::floor((ppqAtEvent - timing.barStartPpq) * 4.0));
+    const auto step = static_cast<size_t>(((sixteenth % grooveSteps) + grooveSteps) % grooveSteps);
+
+    return juce::jmax(0, sampleOffset + timing.stepDelays[step]);
 }
 
 void BurialDrumPluginAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
     const auto numSamples = buffer.getNumSamples();
-    const auto numChannels = buffer.getNumChannels();
 
-    blockTuneSemitones = *parameters.getRawParameterValue("tune");
-    blockDecay = *parameters.getRawParameterValue("decay");
-    blockTone = *parameters.getRawParameterValue("tone");
-    blockDrive = *parameters.getRawParameterValue("drive");
-    blockHatLength = *parameters.getRawParameterValue("hatLength");
+    setSmootherTargets();
+    blockRetireLevel = juce::Decibels::decibelsToGain(parameters.getRawParameterValue("retireLevel")->load(), minRetireLevelDb - 1.0f);
+    blockHitCacheEnabled = *parameters.getRawParameterValue("hitCache") > 0.5f;
+    blockSeed = static_cast<uint64_t>(juce::roundToInt(parameters.getRawParameterValue("seed")->load()));
+    blockClipMode = static_cast<drumdsp::SoftClipMode>(juce::jlimit(0, drumdsp::numSoftClipModes - 1,
+                                                                    juce::roundToInt(parameters.getRawParameterValue("driveQuality")->load())));
 
     for (size_t i = 0; i < drumCount; ++i)
     {
-        if (drumLevelParams[i] != nullptr)
-            blockDrumLevels[i] = *drumLevelParams[i];
-        if (drumTuneParams[i] != nullptr)
-            blockDrumTuneSemitones[i] = *drumTuneParams[i];
-        if (drumDecayParams[i] != nullptr)
-            blockDrumDecay[i] = *drumDecayParams[i];
-        if (drumToneParams[i] != nullptr)
-            blockDrumTone[i] = *drumToneParams[i];
-        if (drumDriveParams[i] != nullptr)
-            blockDrumDrive[i] = *drumDriveParams[i];
+        if (drumVoicesParams[i] != nullptr)
+            blockDrumVoiceCaps[i] = juce::jlimit(1, maxDrumVoices, juce::roundToInt(drumVoicesParams[i]->load()));
+        if (drumChokeParams[i] != nullptr)
+            blockDrumChokeGroups[i] = juce::roundToInt(drumChokeParams[i]->load());
     }
 
-    triggerTestSequenceEvents(numSamples);
+    if (const int voices = juce::roundToInt(parameters.getRawParameterValue("polyphony")->load()); voices != polyphony)
+        applyPolyphony(voices);
 
-    const uint32_t debugMask = debugDrumTriggerMask.exchange(0u);
-    if (debugMask != 0u)
-    {
-        for (size_t i = 0; i < drumCount; ++i)
-        {
-            const uint32_t bit = static_cast<uint32_t>(1u << static_cast<uint32_t>(i));
-            if ((debugMask & bit) == 0u)
-                continue;
+    // With every ramp at rest this is the only parameter update of the block.
+    bool voiceParamsSmoothing = isVoiceParamSmoothing();
+    advanceVoiceParams(0);
+    if (!voiceParamsSmoothing)
+        updateVoiceRetirement();
 
-            triggerDrum(static_cast<DrumType>(static_cast<int>(i)), 0.95f, 0);
-        }
-    }
+    takePendingUserGroove();
+    updateBlockTiming();
+
+    drainCommands(numSamples);
+    triggerSequencerEvents(numSamples);
 
     for (const auto metadata : midiMessages)
     {
@@ -535,60 +2137,396 @@ void BurialDrumPluginAudioProcessor::processBlock(juce::AudioBuffer<float>& buff
         {
             const auto type = noteToDrumType(message.getNoteNumber());
             if (type != DrumType::none)
-                triggerDrum(type, message.getFloatVelocity(), applySwingOffset(metadata.samplePosition, numSamples));
+                queueHit(type, message.getFloatVelocity(), blockStartSample + applyGrooveOffset(metadata.samplePosition));
         }
     }
 
     midiMessages.clear();
     buffer.clear();
 
-    const float lpCoeff = juce::jmap(blockTone, 0.14f, 0.52f);
-    const float driveGain = 1.0f + 6.4f * blockDrive;
-    const float driveTrim = 1.0f / std::sqrt(driveGain);
+    // The fading-voice scratch channel holds a chunk at the render rate.
+    const int factor = oversamplingFactor;
+    mixBuffer.setSize(3, numSamples * factor, false, false, true);
+    mixBuffer.clear(0, 0, numSamples);
+    auto* mix = mixBuffer.getWritePointer(0);
 
-    for (int sample = 0; sample < numSamples; ++sample)
+    // A mix with every drum centred renders mono, straight into the mix.
+    updateStemPlacements();
+    bool stereoMix = false;
+    for (size_t drum = 0; drum < drumCount; ++drum)
+        stereoMix = stereoMix || !stemPlacements[drum].isCentred() || !lastStemPlacements[drum].isCentred();
+
+    const bool renderStems = stereoMix || stemOutputsEnabled;
+    if (renderStems)
     {
-        float mono = 0.0f;
-        bool hasStartedVoice = false;
+        stemBuffer.setSize(drumCount, numSamples, false, false, true);
+        stemBuffer.clear();
+    }
+
+    // Oversampled, voices render into the oversampler's buffer for the
+    // block. Its input is the silent mix or stems, so nothing but the
+    // voices reaches it. A block with no voice to render skips it.
+    const int64_t blockEnd = blockStartSample + numSamples;
+    const bool hasVoices = voicePool.numActive > 0 || (!pendingHits.isEmpty() && pendingHits.nextTime() < blockEnd);
+    juce::dsp::Oversampling<float>* oversampler = nullptr;
+    juce::dsp::AudioBlock<float> blockRateOutput;
+    juce::dsp::AudioBlock<float> renderBlock;
+
+    if (factor > 1 && (hasVoices || oversamplersHoldSignal))
+    {
+        oversampler = renderStems ? stemOversampler.get() : mixOversampler.get();
+        blockRateOutput = renderStems ? juce::dsp::AudioBlock<float>(stemBuffer)
+                                      : juce::dsp::AudioBlock<float>(mixBuffer).getSingleChannelBlock(0).getSubBlock(0, static_cast<size_t>(numSamples));
+
+        // Switching between the two drops the other's short filter tail.
+        if (renderStems != lastBlockRenderedStems)
+            oversampler->reset();
+
+        renderBlock = oversampler->processSamplesUp(blockRateOutput);
+        renderBlock.clear();
+    }
+
+    lastBlockRenderedStems = renderStems;
+
+    // Span of the block in which at least one voice was sounding, overall
+    // and per drum.
+    int renderedStart = numSamples;
+    int renderedEnd = 0;
+    std::array<int, drumCount> drumRenderedStart {};
+    std::array<int, drumCount> drumRenderedEnd {};
+    std::array<int, drumCount> drumRendered {};
+    drumRenderedStart.fill(numSamples);
+
+    // The block is rendered in segments between scheduled hits, so every
+    // voice starts exactly at a segment edge and each segment renders all
+    // active voices from its first sample. Hits due in a later block stay
+    // queued without holding a voice.
+    for (int segmentStart = 0; segmentStart < numSamples;)
+    {
+        while (!pendingHits.isEmpty() && pendingHits.nextTime() <= blockStartSample + segmentStart)
+        {
+            const auto hit = pendingHits.pop();
+            triggerDrum(hit.payload.type, hit.payload.velocity, hit.time);
+        }
+
+        const int segmentEnd = !pendingHits.isEmpty() && pendingHits.nextTime() < blockEnd
+                                   ? static_cast<int>(pendingHits.nextTime() - blockStartSample)
+                                   : numSamples;
 
-        for (auto& v : voices)
+        for (int chunkStart = segmentStart; chunkStart < segmentEnd;)
         {
-            if (!v.active)
-                continue;
+            int chunkEnd = segmentEnd;
+            if (voiceParamsSmoothing)
+            {
+                chunkEnd = juce::jmin(segmentEnd, chunkStart + smoothingSubBlockSamples);
+                advanceVoiceParams(chunkEnd - chunkStart);
+                voiceParamsSmoothing = isVoiceParamSmoothing();
+            }
 
-            if (v.samplesUntilStart > 0)
+            if (factor > 1 && oversampler == nullptr)
             {
-                --v.samplesUntilStart;
+                chunkStart = chunkEnd;
                 continue;
             }
 
-            hasStartedVoice = true;
-            mono += renderVoiceSample(v);
-            ++v.sampleIndex;
+            DrumOutputs outputs;
+            for (size_t drum = 0; drum < drumCount; ++drum)
+            {
+                const auto channel = renderStems ? drum : 0;
+                outputs[drum] = factor > 1 ? renderBlock.getChannelPointer(channel) + chunkStart * factor
+                                           : (renderStems ? stemBuffer.getWritePointer(static_cast<int>(drum)) : mix) + chunkStart;
+            }
+
+            // Rendered lengths come back at the render rate.
+            if (const int rendered = renderActiveVoices(outputs, (chunkEnd - chunkStart) * factor, drumRendered); rendered > 0)
+            {
+                renderedStart = juce::jmin(renderedStart, chunkStart);
+                renderedEnd = juce::jmax(renderedEnd, chunkStart + (rendered + factor - 1) / factor);
+
+                for (size_t drum = 0; drum < drumCount; ++drum)
+                {
+                    if (drumRendered[drum] > 0)
+                    {
+                        drumRenderedStart[drum] = juce::jmin(drumRenderedStart[drum], chunkStart);
+                        drumRenderedEnd[drum] = juce::jmax(drumRenderedEnd[drum], chunkStart + (drumRendered[drum] + factor - 1) / factor);
+                    }
+                }
+            }
+
+            chunkStart = chunkEnd;
+        }
+
+        segmentStart = segmentEnd;
+    }
+
+    blockStartSample = blockEnd;
+    updateVoiceRetirement();
+    updatePartialCounts();
+
+    if (oversampler != nullptr)
+    {
+        if (renderedEnd > 0 || oversamplersHoldSignal)
+            oversampler->processSamplesDown(blockRateOutput);
+
+        // The filters delay and smear the voices, so every drum that sounded
+        // is treated as sounding to the end of the block.
+        oversamplersHoldSignal = renderedEnd > 0;
+        if (renderedEnd > 0)
+        {
+            renderedEnd = numSamples;
+            for (auto& end : drumRenderedEnd)
+                end = end > 0 ? numSamples : 0;
+        }
+    }
+
+    // A drum whose voices all ended in the last block still owes the mix the
+    // delayed copy its width adds, whatever the block size.
+    std::array<bool, drumCount> widthTails {};
+    for (size_t drum = 0; renderStems && drum < drumCount; ++drum)
+        widthTails[drum] = drumRenderedEnd[drum] == 0 && hasWidthTail(drum);
+
+    const bool anyWidthTail = std::any_of(widthTails.begin(), widthTails.end(), [](bool tail) { return tail; });
+
+    // With no voice sounding anywhere in the block, the master chain's
+    // silence reset zeroes every filter state on the first sample, so the
+    // output is exactly the buffer cleared above and stays flagged as clear.
+    if (renderedEnd == 0 && !anyWidthTail)
+    {
+        toneSmoother.skip(numSamples);
+        driveSmoother.skip(numSamples);
+        masterChain = {};
+        stemMasterChains.fill({});
+        lastStemPlacements = stemPlacements;
+        for (auto& history : widthHistory)
+            history.fill(0.0f);
+        return;
+    }
+
+    auto* mixRight = stereoMix ? mixBuffer.getWritePointer(2) : nullptr;
+    if (stereoMix)
+        mixBuffer.clear(2, 0, numSamples);
+
+    const bool stemMaster = *parameters.getRawParameterValue("stemMasterChain") > 0.5f;
+
+    // Each drum is placed in the mix from its stem, and each per-drum output
+    // takes the placed stem through its own master chain or as it is.
+    for (size_t drum = 0; renderStems && drum < drumCount; ++drum)
+    {
+        const auto channel = static_cast<int>(drum);
+        const auto* stem = stemBuffer.getReadPointer(channel);
+        if (drumRenderedEnd[drum] == 0 && !widthTails[drum])
+        {
+            stemMasterChains[drum] = {};
+            widthHistory[drum].fill(0.0f);
+            continue;
         }
 
-        if (!hasStartedVoice && std::abs(mono) < 1.0e-7f)
+        if (stereoMix)
+            placeStem(drum, stem, mix, mixRight, numSamples);
+        else
+            juce::FloatVectorOperations::add(mix, stem, numSamples);
+
+        auto output = getBusBuffer(buffer, false, channel + 1);
+        if (output.getNumChannels() > 0)
         {
-            punchHPState = 0.0f;
-            lpStateL = 0.0f;
-            lpStateR = 0.0f;
+            auto* left = output.getWritePointer(0);
+            auto* right = output.getNumChannels() > 1 && stereoMix ? output.getWritePointer(1) : nullptr;
+
+            if (right != nullptr)
+                placeStem(drum, stem, left, right, numSamples);
+            else
+                juce::FloatVectorOperations::copy(left, stem, numSamples);
+
+            if (stemMaster)
+            {
+                // The stem chains step copies of the ramps the main bus steps below.
+                auto tone = toneSmoother;
+                auto drive = driveSmoother;
+                applyMasterChain(stemMasterChains[drum], left, right, drumRenderedStart[drum], drumRenderedEnd[drum], tone, drive, output);
+            }
+            else if (right == nullptr && output.getNumChannels() > 1)
+            {
+                output.copyFrom(1, 0, left, numSamples);
+            }
         }
 
-        punchHPState += 0.11f * (mono - punchHPState);
-        const float transient = mono - punchHPState;
-        mono += transient * 0.95f;
-        mono = softClip(mono * 0.62f * driveGain) * driveTrim;
+        updateWidthHistory(drum, stem, numSamples);
+    }
+
+    lastStemPlacements = stemPlacements;
+
+    auto mainOutput = getBusBuffer(buffer, false, 0);
+    applyMasterChain(masterChain, mix, mixRight, renderedStart, renderedEnd, toneSmoother, driveSmoother, mainOutput);
+}
+
+void BurialDrumPluginAudioProcessor::updateStemPlacements()
+{
+    for (size_t drum = 0; drum < drumCount; ++drum)
+    {
+        const float pan = drumPanParams[drum] != nullptr ? drumPanParams[drum]->load() : 0.0f;
+        const float width = drumWidthParams[drum] != nullptr ? drumWidthParams[drum]->load() : 0.0f;
+        auto& placement = stemPlacements[drum];
+
+        // Constant-power pan, scaled so that the centre is unity on each side.
+        const float angle = (pan + 1.0f) * juce::MathConstants<float>::pi * 0.25f;
+        const bool centred = juce::exactlyEqual(pan, 0.0f);
+        placement.leftGain = centred ? 1.0f : juce::MathConstants<float>::sqrt2 * std::cos(angle);
+        placement.rightGain = centred ? 1.0f : juce::MathConstants<float>::sqrt2 * std::sin(angle);
+        placement.side = width * maxWidthSide;
+    }
+}
+
+bool BurialDrumPluginAudioProcessor::hasWidthTail(size_t drum) const
+{
+    if (juce::exactlyEqual(lastStemPlacements[drum].side, 0.0f) && juce::exactlyEqual(stemPlacements[drum].side, 0.0f))
+        return false;
+
+    const auto& history = widthHistory[drum];
+    return std::any_of(history.end() - widthDelaySamples, history.end(), [](float x) { return !juce::exactlyEqual(x, 0.0f); });
+}
+
+void BurialDrumPluginAudioProcessor::placeStem(size_t drum, const float* stem, float* left, float* right, int numSamples) const
+{
+    // Placement changes ramp over the block; steady ones are plain vector adds.
+    const auto& from = lastStemPlacements[drum];
+    const auto& to = stemPlacements[drum];
+    const float invNumSamples = 1.0f / static_cast<float>(numSamples);
+
+    addWithGainRamp(left, stem, numSamples, from.leftGain, (to.leftGain - from.leftGain) * invNumSamples);
+    addWithGainRamp(right, stem, numSamples, from.rightGain, (to.rightGain - from.rightGain) * invNumSamples);
+
+    if (juce::exactlyEqual(from.side, 0.0f) && juce::exactlyEqual(to.side, 0.0f))
+        return;
+
+    // The delayed stem is the end of the last block, then this one.
+    const float* history = widthHistory[drum].data() + (maxWidthDelaySamples - widthDelaySamples);
+    const int fromHistory = juce::jmin(widthDelaySamples, numSamples);
+
+    const float sideLeft = from.leftGain * from.side;
+    const float sideRight = -from.rightGain * from.side;
+    const float sideLeftStep = (to.leftGain * to.side - sideLeft) * invNumSamples;
+    const float sideRightStep = (-to.rightGain * to.side - sideRight) * invNumSamples;
+    const auto atHistoryEnd = static_cast<float>(fromHistory);
+
+    addWithGainRamp(left, history, fromHistory, sideLeft, sideLeftStep);
+    addWithGainRamp(right, history, fromHistory, sideRight, sideRightStep);
+    addWithGainRamp(left + fromHistory, stem, numSamples - fromHistory, sideLeft + sideLeftStep * atHistoryEnd, sideLeftStep);
+    addWithGainRamp(right + fromHistory, stem, numSamples - fromHistory, sideRight + sideRightStep * atHistoryEnd, sideRightStep);
+}
+
+void BurialDrumPluginAudioProcessor::updateWidthHistory(size_t drum, const float* stem, int numSamples)
+{
+    // Keeps the latest maxWidthDelaySamples of the stem, oldest first.
+    auto& history = widthHistory[drum];
+    constexpr int size = maxWidthDelaySamples;
+
+    if (numSamples >= size)
+    {
+        std::copy(stem + numSamples - size, stem + numSamples, history.begin());
+        return;
+    }
+
+    std::copy(history.begin() + numSamples, history.end(), history.begin());
+    std::copy(stem, stem + numSamples, history.end() - numSamples);
+}
+
+void BurialDrumPluginAudioProcessor::applyMasterChain(MasterChainState& state, float* left, float* right, int renderedStart, int renderedEnd,
+                                                      ParameterSmoother& tone, ParameterSmoother& drive, juce::AudioBuffer<float>& output)
+{
+    const int numSamples = output.getNumSamples();
+    const int numChannels = output.getNumChannels();
+
+    // A stereo mix into a mono output is folded down first.
+    if (right != nullptr && numChannels < 2)
+    {
+        juce::FloatVectorOperations::add(left, right, numSamples);
+        juce::FloatVectorOperations::multiply(left, 0.5f, numSamples);
+        right = nullptr;
+    }
+
+    if (numChannels == 0)
+    {
+        tone.skip(numSamples);
+        drive.skip(numSamples);
+        return;
+    }
 
-        // Dark one-pole filtering and a tiny channel offset for texture.
-        lpStateL += lpCoeff * (mono - lpStateL);
-        lpStateR += lpCoeff * ((mono * 0.997f) - lpStateR);
+    // A mono mix runs the chain once and is copied to both sides.
+    if (right == nullptr)
+    {
+        applyMasterChain(state, 0, left, renderedStart, renderedEnd, tone, drive, output.getWritePointer(0), numSamples);
+        state.punchHPState[1] = state.punchHPState[0];
+        state.lpState[1] = state.lpState[0];
 
-        if (numChannels > 0)
-            buffer.setSample(0, sample, lpStateL);
         if (numChannels > 1)
-            buffer.setSample(1, sample, lpStateR);
+            output.copyFrom(1, 0, output, 0, 0, numSamples);
+        return;
+    }
+
+    // The left side steps copies of the ramps the right side then steps.
+    auto leftTone = tone;
+    auto leftDrive = drive;
+    applyMasterChain(state, 0, left, renderedStart, renderedEnd, leftTone, leftDrive, output.getWritePointer(0), numSamples);
+    applyMasterChain(state, 1, right, renderedStart, renderedEnd, tone, drive, output.getWritePointer(1), numSamples);
+}
+
+void BurialDrumPluginAudioProcessor::applyMasterChain(MasterChainState& state, size_t channel, const float* mix, int renderedStart, int renderedEnd,
+                                                      ParameterSmoother& tone, ParameterSmoother& drive, float* output, int numSamples)
+{
+    auto& punchHPState = state.punchHPState[channel];
+    auto& lpState = state.lpState[channel];
+
+    // The filters are only cleared outside the rendered span, so the span
+    // itself runs block-parallel.
+    const int spanStart = juce::jlimit(0, numSamples, renderedStart);
+    const int spanEnd = juce::jlimit(spanStart, numSamples, renderedEnd);
+
+    // Punch: the mix plus 0.95 of its difference from a slow lowpass.
+    auto* driven = mixBuffer.getWritePointer(1);
+    masterOnePole(mix, mix, driven, numSamples, spanStart, spanEnd, 0.11f, punchHPState);
+    juce::FloatVectorOperations::multiply(driven, -0.95f, numSamples);
+    juce::FloatVectorOperations::addWithMultiply(driven, mix, 1.95f, numSamples);
+
+    // The settings are stepped per sample, and only while ramping. The
+    // drive stage steps a copy of the drive ramp so the tone stage can step
+    // the same values for the trim.
+    const bool smoothing = tone.isSmoothing() || drive.isSmoothing();
+
+    if (smoothing)
+    {
+        auto driveRamp = drive;
+        for (int sample = 0; sample < numSamples; ++sample)
+            driven[sample] *= 0.62f * (1.0f + 6.4f * driveRamp.getNextValue());
     }
+    else
+    {
+        juce::FloatVectorOperations::multiply(driven, 0.62f * (1.0f + 6.4f * drive.getCurrentValue()), numSamples);
+    }
+
+    drumdsp::softClipBlock(blockClipMode, driven, numSamples);
+
+    // Dark one-pole filtering.
+    if (!smoothing)
+    {
+        const float driveTrim = 1.0f / std::sqrt(1.0f + 6.4f * drive.getCurrentValue());
+        juce::FloatVectorOperations::multiply(driven, driveTrim, numSamples);
+        masterOnePole(mix, driven, output, numSamples, spanStart, spanEnd,
+                      juce::jmap(tone.getCurrentValue(), 0.14f, 0.52f), lpState);
+        return;
+    }
+
+    for (int sample = 0; sample < numSamples; ++sample)
+    {
+        const bool hasStartedVoice = sample >= spanStart && sample < spanEnd;
 
+        if (!hasStartedVoice && std::abs(mix[sample]) < 1.0e-7f)
+            lpState = 0.0f;
+
+        const float lpCoeff = juce::jmap(tone.getNextValue(), 0.14f, 0.52f);
+        const float driveTrim = 1.0f / std::sqrt(1.0f + 6.4f * drive.getNextValue());
+        lpState += lpCoeff * (driven[sample] * driveTrim - lpState);
+        output[sample] = lpState;
+    }
 }
 
 void BurialDrumPluginAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
@@ -609,7 +2547,21 @@ void BurialDrumPluginAudioProcessor::setStateInformation(const void* data, int s
     if (!xmlState->hasTagName(parameters.state.getType()))
         return;
 
-    parameters.replaceState(juce::ValueTree::fromXml(*xmlState));
+    // The saved groove comes back with the rest of the state, so the audio
+    // thread only needs to be handed a copy.
+    const auto state = juce::ValueTree::fromXml(*xmlState);
+    const auto values = juce::StringArray::fromTokens(state.getProperty("userGroove").toString(), " ", "");
+    if (values.size() == grooveSteps)
+    {
+        GrooveTemplate groove {};
+        for (int step = 0; step < grooveSteps; ++step)
+            groove[static_cast<size_t>(step)] = values[step].getFloatValue();
+
+        queueUserGroove(groove);
+    }
+
+    loadSequencerState(state.getChildWithName("Sequencer"));
+    parameters.replaceState(state);
     cacheParameterPointers();
 }
 
@@ -2,11 +2,17 @@
 
 #include <array>
 #include <cstdint>
-#include <random>
 
 #include <juce_audio_processors/juce_audio_processors.h>
 
-class BurialDrumPluginAudioProcessor final : public juce::AudioProcessor
+#include "DrumDsp.h"
+#include "EventQueue.h"
+#include "HitCache.h"
+#include "StepSequencer.h"
+
+class BurialDrumPluginAudioProcessor final : public juce::AudioProcessor,
+                                             private juce::AudioProcessorValueTreeState::Listener,
+                                             private juce::AsyncUpdater
 {
 public:
     enum class DrumType
@@ -22,11 +28,16 @@ public:
         none
     };
 
+    // Per-16th delays over one 4/4 bar, as fractions of a 16th note.
+    static constexpr int grooveSteps = 16;
+    using GrooveTemplate = std::array<float, grooveSteps>;
+
     BurialDrumPluginAudioProcessor();
-    ~BurialDrumPluginAudioProcessor() override = default;
+    ~BurialDrumPluginAudioProcessor() override;
 
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
+    void setNonRealtime(bool isNonRealtime) noexcept override;
 
     bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
 
@@ -40,7 +51,7 @@ public:
     bool acceptsMidi() const override { return true; }
     bool producesMidi() const override { return false; }
     bool isMidiEffect() const override { return false; }
-    double getTailLengthSeconds() const override { return 2.5; }
+    double getTailLengthSeconds() const override { return tailLengthSeconds.load(); }
 
     int getNumPrograms() override { return 1; }
     int getCurrentProgram() override { return 0; }
@@ -52,29 +63,195 @@ public:
     void setStateInformation(const void*, int) override;
 
     juce::AudioProcessorValueTreeState& getAPVTS() { return parameters; }
-    void startTestSequence();
-    void queueDrumTestHit(DrumType type);
+
+    // Message-thread controls, passed to the audio thread through the
+    // command queue. Each returns false if the queue was full.
+    bool startSequencer(bool loop = false);
+    bool stopSequencer();
+    bool queueDrumTestHit(DrumType type, float velocity = 0.95f);
+    bool notifyPresetLoaded();
+
+    // Sets the template used when Groove is "User" and saves it with the
+    // state. Message thread only; always returns true.
+    bool setUserGroove(const GrooveTemplate& delays);
+
+    // Sequencer editing, on the message thread. Each change is saved with the
+    // state and reaches the audio thread at its next block; a velocity of
+    // zero clears a step.
+    bool setSequencerStep(int pattern, int step, DrumType type, float velocity);
+    bool setSequencerPatternLength(int pattern, int numSteps);
+    bool setSequencerChain(const int* patterns, int length);
+
+    // The bank being edited, for the editor's step grid; message thread only.
+    // The change count goes up whenever the bank changes, including when the
+    // host restores a state, and is safe to read from any thread.
+    float getSequencerStep(int pattern, int step, DrumType type) const;
+    int getSequencerPatternLength(int pattern) const;
+    juce::Array<int> getSequencerChain() const;
+    int getSequencerChangeCount() const { return sequencerChanges.load(); }
+
+    // Fixed partials computed for the voices sounding at the end of the last
+    // block, and how many more were culled for lying above the host's band.
+    // Safe to read from any thread; the editor shows both.
+    int getSoundingPartialCount() const { return soundingPartials.load(); }
+    int getCulledPartialCount() const { return culledPartials.load(); }
 
 private:
     static constexpr int drumCount = 8;
 
+    // Working copy of one voice's state, loaded from the pool for the length of a render.
     struct Voice
     {
         bool active = false;
         DrumType type = DrumType::none;
         float velocity = 0.0f;
-        int samplesUntilStart = 0;
         int sampleIndex = 0;
-        float phaseA = 0.0f;
-        float phaseB = 0.0f;
-        float phaseC = 0.0f;
-        uint32_t noiseState = 1u;
+        int endSample = 0;
+        std::array<drumdsp::Phasor<float>, 3> partials {};
+        drumdsp::NoiseStreams noise;
         float toneState = 0.0f;
     };
 
-    static constexpr int maxVoices = 32;
-    std::array<Voice, maxVoices> voices;
+    // Polyphony follows its parameter. A few slots beyond it are kept
+    // for stolen voices to fade out in while their replacement starts.
+    static constexpr int minPolyphony = 16;
+    static constexpr int maxPolyphony = 128;
+    static constexpr int maxFadingVoices = 8;
+    static constexpr int maxVoices = maxPolyphony + maxFadingVoices;
+
+    // Structure-of-arrays voice store. Only the slots listed in activeVoices
+    // are visited while rendering, so idle slots cost nothing; unused slots
+    // are kept on a free list so allocation and release take constant time.
+    struct VoicePool
+    {
+        std::array<DrumType, maxVoices> type {};
+        std::array<float, maxVoices> velocity {};
+        std::array<int, maxVoices> sampleIndex {};
+
+        // Sample from which the voice stays below the retire level.
+        std::array<int, maxVoices> endSample {};
+        std::array<std::array<drumdsp::Phasor<float>, maxVoices>, 3> partials {};
+        std::array<drumdsp::NoiseStreams, maxVoices> noise {};
+        std::array<float, maxVoices> toneState {};
+
+        // Hit cache entry a voice plays back, or records into; -1 if none.
+        std::array<int, maxVoices> cacheEntry {};
+        std::array<bool, maxVoices> cacheRecording {};
+
+        // Linear fade-out of a stolen voice; a step of zero means not fading.
+        std::array<float, maxVoices> fadeGain {};
+        std::array<float, maxVoices> fadeStep {};
+        int numFading = 0;
+
+        std::array<int, maxVoices> activeVoices {};
+        std::array<int, maxVoices> activePosition {};
+        int numActive = 0;
+
+        std::array<int, maxVoices> freeVoices {};
+        int numFree = 0;
+
+        int numSlots = 0;
+
+        void clear(int slotCount);
+        void setNumSlots(int slotCount);
+        bool isActive(int slot) const { return activePosition[static_cast<size_t>(slot)] >= 0; }
+        bool isFading(int slot) const { return fadeStep[static_cast<size_t>(slot)] > 0.0f; }
+        int allocate();
+        void release(int slot);
+        void startFade(int slot, float step);
+        Voice load(int slot) const;
+        void store(int slot, const Voice& v);
+    };
+
+    VoicePool voicePool;
+    int polyphony = 32;
+    float voiceFadeStep = 1.0f;
+
+    // Hits waiting to start, stamped in samples since prepareToPlay. MIDI,
+    // swing, the test sequence and UI triggers all schedule through here,
+    // and a voice is only taken in the block where its hit begins.
+    struct PendingHit
+    {
+        DrumType type = DrumType::none;
+        float velocity = 0.0f;
+    };
+
+    static constexpr int maxPendingHits = 256;
+    EventQueue<PendingHit, maxPendingHits> pendingHits;
+    int64_t blockStartSample = 0;
+
+    // Terms shared by every voice of one drum, derived once per block.
+    struct DrumBlockParams
+    {
+        float invSampleRate = 1.0f / 44100.0f;
+        float tuneMul = 1.0f;
+        float decayMul = 1.0f;
+        float hatMul = 1.0f;
+        float level = 1.0f;
+        float toneCoeff = 0.32f;
+        float toneBlend = 0.5f;
+        float driveGain = 1.0f;
+        float driveTrim = 1.0f;
+        drumdsp::SoftClipMode clipMode = drumdsp::SoftClipMode::pade;
+        float retireLevel = 3.1622776e-5f;
+
+        // Keeps the in-band noise level when rendering oversampled.
+        float noiseGain = 1.0f;
+
+        // Weight of each fixed partial at its tuned frequency: one below the
+        // band limit, fading to zero at the host's Nyquist frequency. The
+        // partials from activePartials on are culled and never computed.
+        std::array<float, 3> partialGain { 1.0f, 1.0f, 1.0f };
+        int activePartials = 3;
+
+        bool operator==(const DrumBlockParams& other) const
+        {
+            using juce::exactlyEqual;
+            return exactlyEqual(invSampleRate, other.invSampleRate) && exactlyEqual(tuneMul, other.tuneMul)
+                && exactlyEqual(decayMul, other.decayMul) && exactlyEqual(hatMul, other.hatMul)
+                && exactlyEqual(level, other.level) && exactlyEqual(toneCoeff, other.toneCoeff)
+                && exactlyEqual(toneBlend, other.toneBlend) && exactlyEqual(driveGain, other.driveGain)
+                && exactlyEqual(driveTrim, other.driveTrim) && clipMode == other.clipMode
+                && exactlyEqual(retireLevel, other.retireLevel) && exactlyEqual(noiseGain, other.noiseGain)
+                && exactlyEqual(partialGain[0], other.partialGain[0]) && exactlyEqual(partialGain[1], other.partialGain[1])
+                && exactlyEqual(partialGain[2], other.partialGain[2]);
+        }
+
+        bool operator!=(const DrumBlockParams& other) const { return !(*this == other); }
+    };
+
+    // Each drum gets its own kernel instantiation so the hot loop carries no
+    // type switch; the kernel is picked once per voice per block.
+    using VoiceKernel = void (*)(Voice&, const DrumBlockParams&, float* dst, int numSamples);
+
+    template <DrumType type>
+    static void renderVoiceKernel(Voice& v, const DrumBlockParams& p, float* dst, int numSamples);
+
+    static const std::array<VoiceKernel, drumCount> voiceKernels;
+
+    // Shared synthesis loop: renders one voice per lane of SampleType for
+    // exactly numSamples samples, leaving cut-off handling to the callers.
+    template <DrumType type, typename SampleType, drumdsp::SoftClipMode clipMode>
+    static void renderVoiceLanes(Voice* const* voices, const DrumBlockParams& p, float* dst, int numSamples);
+
+    // Picks the renderVoiceLanes instantiation for the block's drive quality.
+    template <DrumType type, typename SampleType>
+    static void renderVoiceLanes(drumdsp::SoftClipMode clipMode, Voice* const* voices,
+                                 const DrumBlockParams& p, float* dst, int numSamples);
+
+   #if JUCE_USE_SIMD
+    static constexpr int voiceGroupSize = static_cast<int>(drumdsp::FloatVec::size());
+
+    // Renders voiceGroupSize voices of one drum side by side in SIMD lanes.
+    using VoiceGroupKernel = void (*)(Voice* voices, const DrumBlockParams&, float* dst, int numSamples);
+
+    template <DrumType type>
+    static void renderVoiceGroupKernel(Voice* voices, const DrumBlockParams& p, float* dst, int numSamples);
+
+    static const std::array<VoiceGroupKernel, drumCount> voiceGroupKernels;
+   #endif
 
+    static BusesProperties createBusesProperties();
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     static int drumTypeToIndex(DrumType type);
     static const char* drumIdPrefix(DrumType type);
@@ -82,23 +259,119 @@ private:
     void cacheParameterPointers();
 
     DrumType noteToDrumType(int midiNote) const;
-    void triggerDrum(DrumType type, float velocity, int sampleOffset);
-    float renderVoiceSample(Voice& v) const;
-    int applySwingOffset(int sampleOffset, int blockSize) const;
-    void triggerTestSequenceEvents(int blockSize);
-
-    static float nextNoiseSample(uint32_t& state);
-    static float softClip(float x);
+    void queueHit(DrumType type, float velocity, int64_t sampleTime);
+    void triggerDrum(DrumType type, float velocity, int64_t sampleTime);
+    using DrumOutputs = std::array<float*, drumCount>;
+    int renderActiveVoices(const DrumOutputs& dst, int numSamples, std::array<int, drumCount>& drumRendered);
+    int renderVoiceBlock(int slot, float* dst, int numSamples);
+    int renderCachedVoiceBlock(int slot, float* dst, int numSamples);
+    int renderFadingVoiceBlock(int slot, float* dst, int numSamples);
+    int allocateVoice();
+    int findQuietestVoice(bool fading, DrumType type = DrumType::none) const;
+    void chokeVoices(DrumType type);
+    float voiceLevel(int slot) const;
+    float voiceGain(int slot) const;
+    int voiceEndSample(int slot) const;
+    void startCachedHit(int slot, int drumIndex);
+    void releaseVoiceCache(int slot);
+   #if JUCE_USE_SIMD
+    int renderVoiceGroup(const int* slots, int drumIndex, float* dst, int numSamples);
+   #endif
+    void updateBlockTiming();
+    int applyGrooveOffset(int sampleOffset) const;
+    void triggerSequencerEvents(int numSamples);
+    void publishSequencer();
+    void resetSequencerEdits();
+    void loadSequencerState(const juce::ValueTree& tree);
 
     double currentSampleRate = 44100.0;
 
-    // Global mellowing to keep the kit dark and lo-fi.
-    float lpStateL = 0.0f;
-    float lpStateR = 0.0f;
-    float punchHPState = 0.0f;
+    // Voices render at oversamplingFactor times the host rate, into the
+    // oversamplers' buffers, and are filtered back down once per block. The
+    // factor is chosen when playback is prepared, from the Oversampling
+    // setting and whether the host is rendering offline. Changes to either
+    // in between are only reported to the host, as a new latency.
+    static constexpr int maxOversamplingOrder = 2;
+    std::array<int, maxOversamplingOrder + 1> oversamplingLatencies {};
+    std::atomic<bool> oversamplingChangePending { false };
+    int oversamplingFactor = 1;
+    double renderSampleRate = 44100.0;
+    std::unique_ptr<juce::dsp::Oversampling<float>> mixOversampler;
+    std::unique_ptr<juce::dsp::Oversampling<float>> stemOversampler;
+    bool lastBlockRenderedStems = false;
+    bool oversamplersHoldSignal = false;
+
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+    void handleAsyncUpdate() override;
+    int getOversamplingOrder() const;
+
+    // Channel 0 is the bus all voices are summed into, the left side when
+    // the mix is stereo; channel 1 is scratch for fading voices and then for
+    // the master chain; channel 2 is the right side of a stereo mix.
+    juce::AudioBuffer<float> mixBuffer;
+
+    // When a drum is panned or widened, or any per-drum output is enabled,
+    // each drum renders into its own channel here and is placed in the mix
+    // from there.
+    juce::AudioBuffer<float> stemBuffer;
+    bool stemOutputsEnabled = false;
+
+    // Placement of a drum in the stereo mix: left = leftGain * (x + side * d)
+    // and right = rightGain * (x - side * d), where d is x delayed by a
+    // fraction of a millisecond. The complementary comb widens noisy sounds
+    // such as cymbals and cancels in the mono sum.
+    struct StemPlacement
+    {
+        float leftGain = 1.0f;
+        float rightGain = 1.0f;
+        float side = 0.0f;
+
+        bool isCentred() const
+        {
+            return juce::exactlyEqual(leftGain, 1.0f) && juce::exactlyEqual(rightGain, 1.0f) && juce::exactlyEqual(side, 0.0f);
+        }
+    };
+
+    static constexpr int maxWidthDelaySamples = 128;
+
+    std::array<StemPlacement, drumCount> stemPlacements {};
+    std::array<StemPlacement, drumCount> lastStemPlacements {};
+    std::array<std::array<float, maxWidthDelaySamples>, drumCount> widthHistory {};
+    int widthDelaySamples = 29;
+
+    void updateStemPlacements();
+    bool hasWidthTail(size_t drum) const;
+    void placeStem(size_t drum, const float* stem, float* left, float* right, int numSamples) const;
+    void updateWidthHistory(size_t drum, const float* stem, int numSamples);
+
+    // Global mellowing to keep the kit dark and lo-fi. The main bus and each
+    // per-drum bus run the chain with their own state, per channel.
+    struct MasterChainState
+    {
+        std::array<float, 2> punchHPState {};
+        std::array<float, 2> lpState {};
+    };
+
+    MasterChainState masterChain;
+    std::array<MasterChainState, drumCount> stemMasterChains {};
+
+    // Optional store of rendered hits. In cache mode velocities are quantised
+    // and each drum cycles through a few fixed phase/noise variations, so
+    // repeated hits share entries.
+    static constexpr size_t hitCacheBytes = 16 * 1024 * 1024;
+    static constexpr int hitCacheEntries = 256;
+    static constexpr int hitCacheVariations = 4;
+    static constexpr int hitCacheVelocitySteps = 127;
+
+    HitCache hitCache;
+    std::array<int, drumCount> hitCacheNextVariation {};
+    bool blockHitCacheEnabled = false;
+
+    // Voice randomisation is derived from this seed and each hit's time.
+    uint64_t blockSeed = 0;
+    int64_t lastHitTime = -1;
+    int hitsAtSameTime = 0;
 
-    std::mt19937 rng;
-    std::uniform_real_distribution<float> random01 { 0.0f, 1.0f };
     juce::AudioProcessorValueTreeState parameters;
 
     // Cached raw parameter pointers for per-drum controls.
@@ -107,23 +380,137 @@ private:
     std::array<std::atomic<float>*, drumCount> drumDecayParams {};
     std::array<std::atomic<float>*, drumCount> drumToneParams {};
     std::array<std::atomic<float>*, drumCount> drumDriveParams {};
+    std::array<std::atomic<float>*, drumCount> drumVoicesParams {};
+    std::array<std::atomic<float>*, drumCount> drumChokeParams {};
+    std::array<std::atomic<float>*, drumCount> drumPanParams {};
+    std::array<std::atomic<float>*, drumCount> drumWidthParams {};
+    std::atomic<float>* swingParam = nullptr;
+    std::atomic<float>* swingDivisionParam = nullptr;
+    std::atomic<float>* grooveParam = nullptr;
+    std::atomic<float>* sequencerFollowParam = nullptr;
 
-    // Updated at block start from parameters.
+    // Updated at block start from parameters; the continuous ones follow
+    // their smoothers below and can change within a block.
     float blockTuneSemitones = 0.0f;
     float blockDecay = 0.9f;
-    float blockTone = 0.25f;
-    float blockDrive = 0.2f;
     float blockHatLength = 1.0f;
+    drumdsp::SoftClipMode blockClipMode = drumdsp::SoftClipMode::pade;
+    float blockRetireLevel = 3.1622776e-5f;
     std::array<float, drumCount> blockDrumLevels { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f };
     std::array<float, drumCount> blockDrumTuneSemitones { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
     std::array<float, drumCount> blockDrumDecay { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f };
     std::array<float, drumCount> blockDrumTone { 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f };
     std::array<float, drumCount> blockDrumDrive { 0.2f, 0.2f, 0.2f, 0.2f, 0.2f, 0.2f, 0.2f, 0.2f };
+    std::array<int, drumCount> blockDrumVoiceCaps { 4, 4, 4, 4, 3, 4, 3, 4 };
+    std::array<int, drumCount> blockDrumChokeGroups { 0, 0, 1, 1, 0, 0, 0, 0 };
+    std::array<DrumBlockParams, drumCount> drumBlockParams {};
+    std::array<bool, drumCount> drumBlockParamsChanged {};
+
+    // Continuous parameters ramp to each new value. While a voice parameter
+    // is ramping the block renders in sub-blocks, each with the drum
+    // parameters recomputed; once every ramp is done the block renders whole.
+    using ParameterSmoother = juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear>;
+    static constexpr int smoothingSubBlockSamples = 32;
+
+    ParameterSmoother tuneSmoother;
+    ParameterSmoother decaySmoother;
+    ParameterSmoother toneSmoother;
+    ParameterSmoother driveSmoother;
+    ParameterSmoother hatLengthSmoother;
+    std::array<ParameterSmoother, drumCount> drumLevelSmoothers {};
+    std::array<ParameterSmoother, drumCount> drumTuneSmoothers {};
+    std::array<ParameterSmoother, drumCount> drumDecaySmoothers {};
+    std::array<ParameterSmoother, drumCount> drumToneSmoothers {};
+    std::array<ParameterSmoother, drumCount> drumDriveSmoothers {};
+
+    void setSmootherTargets();
+    bool isVoiceParamSmoothing() const;
+    void advanceVoiceParams(int numSamples);
+    void updateDrumBlockParams();
+    void updateVoiceRetirement();
+    void updatePartialCounts();
+    void applyMasterChain(MasterChainState& state, size_t channel, const float* mix, int renderedStart, int renderedEnd,
+                          ParameterSmoother& tone, ParameterSmoother& drive, float* output, int numSamples);
+    void applyMasterChain(MasterChainState& state, float* left, float* right, int renderedStart, int renderedEnd,
+                          ParameterSmoother& tone, ParameterSmoother& drive, juce::AudioBuffer<float>& output);
+
+    // Host transport and groove timing, taken once per block so that timing
+    // a note needs no playhead query or parameter lookup.
+    struct BlockTiming
+    {
+        bool hasTempo = false;
+        bool isPlaying = false;
+        double bpm = 120.0;
+        double ppqAtStart = 0.0;
+        double ppqPerSample = 0.0;
+        double barStartPpq = 0.0;
+
+        // Host timeline position of the block's first sample, while playing.
+        bool hasTimelinePosition = false;
+        int64_t timelineSampleAtStart = 0;
+
+        // Delay in samples of a note on each 16th of the bar.
+        bool hasGroove = false;
+        std::array<int, grooveSteps> stepDelays {};
+    };
+
+    BlockTiming blockTiming;
+    GrooveTemplate userGroove {};
+
+    // A new user groove waits here for the audio thread, which only
+    // try-locks, rather than in the command queue: hosts may restore state
+    // from a thread other than the message thread, and before
+    // prepareToPlay, which clears the queue.
+    juce::SpinLock userGrooveLock;
+    GrooveTemplate pendingUserGroove {};
+    bool userGroovePending = false;
+
+    void queueUserGroove(const GrooveTemplate& delays);
+    void takePendingUserGroove();
+
+    // Longest full-velocity hit at the current settings, for the host.
+    std::atomic<double> tailLengthSeconds { 2.5 };
+
+    std::atomic<int> soundingPartials { 0 };
+    std::atomic<int> culledPartials { 0 };
+
+    // Single-producer, single-consumer queue from the message thread to the
+    // audio thread, drained at the start of every block.
+    struct Command
+    {
+        enum class Type
+        {
+            trigger,
+            startSequence,
+            stopSequence,
+            presetLoaded
+        };
+
+        Type type = Type::trigger;
+        DrumType drum = DrumType::none;
+        float velocity = 0.0f;
+        int value = 0;
+        double timeMs = 0.0; // Millisecond counter when the command was sent.
+    };
+
+    static constexpr int commandQueueSize = 256;
+
+    bool pushCommand(const Command& command);
+    void drainCommands(int numSamples);
+    void applyPolyphony(int numVoices);
+
+    juce::AbstractFifo commandFifo { commandQueueSize };
+    std::array<Command, commandQueueSize> commands {};
+
+    // The audio thread plays sequencer; sequencerEdits is the message
+    // thread's copy, published whole after each change.
+    StepSequencer sequencer;
+    StepSequencer::Bank sequencerEdits;
+    std::atomic<int> sequencerChanges { 0 };
 
-    std::atomic<bool> testSequenceRequested { false };
-    std::atomic<uint32_t> debugDrumTriggerMask { 0u };
-    bool testSequencePlaying = false;
-    int64_t testSequenceSampleCursor = 0;
+    // Set while the sequencer runs because the host transport started it,
+    // so that it stops with the transport.
+    bool sequencerStartedByHost = false;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BurialDrumPluginAudioProcessor)
 };
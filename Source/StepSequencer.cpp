@@ -0,0 +1,181 @@
+#include "StepSequencer.h"
+
+bool StepSequencer::Pattern::setHit(int step, int drum, float velocity)
+{
+    if (step < 0 || step >= maxSteps)
+        return false;
+
+    // Hits are kept sorted by step; the new one goes after any on its step.
+    int index = 0;
+    while (index < numHits && hits[static_cast<size_t>(index)].step <= step)
+    {
+        auto& hit = hits[static_cast<size_t>(index)];
+        if (hit.step == step && hit.drum == drum)
+        {
+            if (velocity > 0.0f)
+            {
+                hit.velocity = std::min(velocity, 1.0f);
+                return true;
+            }
+
+            std::copy(hits.begin() + index + 1, hits.begin() + numHits, hits.begin() + index);
+            --numHits;
+            return true;
+        }
+
+        ++index;
+    }
+
+    if (velocity <= 0.0f)
+        return true;
+
+    if (numHits >= static_cast<int>(hits.size()))
+        return false;
+
+    std::copy_backward(hits.begin() + index, hits.begin() + numHits, hits.begin() + numHits + 1);
+    hits[static_cast<size_t>(index)] = { step, drum, std::min(velocity, 1.0f) };
+    ++numHits;
+    return true;
+}
+
+void StepSequencer::Pattern::setLength(int steps)
+{
+    numSteps = std::clamp(steps, 1, maxSteps);
+}
+
+void StepSequencer::Pattern::clear()
+{
+    numHits = 0;
+}
+
+float StepSequencer::Pattern::getVelocity(int step, int drum) const
+{
+    for (int i = firstHitFrom(step); i < numHits && hits[static_cast<size_t>(i)].step == step; ++i)
+        if (hits[static_cast<size_t>(i)].drum == drum)
+            return hits[static_cast<size_t>(i)].velocity;
+
+    return 0.0f;
+}
+
+int StepSequencer::Pattern::firstHitFrom(double step) const
+{
+    const auto end = hits.begin() + numHits;
+    const auto found = std::lower_bound(hits.begin(), end, step, [](const Hit& hit, double s)
+    {
+        return static_cast<double>(hit.step) < s;
+    });
+
+    return static_cast<int>(found - hits.begin());
+}
+
+bool StepSequencer::Bank::setChain(const int* patternIndices, int length)
+{
+    if (length < 1 || length > maxChainLength)
+        return false;
+
+    for (int i = 0; i < length; ++i)
+        if (patternIndices[i] < 0 || patternIndices[i] >= maxPatterns)
+            return false;
+
+    std::copy(patternIndices, patternIndices + length, chain.begin());
+    chainLength = length;
+    return true;
+}
+
+int StepSequencer::Bank::getChainSteps() const
+{
+    int steps = 0;
+    for (int i = 0; i < chainLength; ++i)
+        steps += patterns[static_cast<size_t>(chain[static_cast<size_t>(i)])].numSteps;
+
+    return steps;
+}
+
+void StepSequencer::publish(const Bank& bank)
+{
+    // Claiming the write also withdraws any bank not yet picked up, so the
+    // audio thread cannot switch buffers while this one is being filled.
+    int state = bankState.load();
+    while (!bankState.compare_exchange_weak(state, (state | writingBit) & ~readyBit))
+    {
+    }
+
+    banks[static_cast<size_t>(1 - (state & liveIndexBit))] = bank;
+
+    state = bankState.load();
+    while (!bankState.compare_exchange_weak(state, (state | readyBit) & ~writingBit))
+    {
+    }
+}
+
+void StepSequencer::reset()
+{
+    playing = false;
+    looping = false;
+    chainIndex = 0;
+    cursor = 0;
+    position = 0.0;
+}
+
+void StepSequencer::start(bool loop)
+{
+    looping = loop;
+    playing = true;
+    locate(0.0);
+}
+
+void StepSequencer::beginBlock()
+{
+    int state = bankState.load();
+    if ((state & readyBit) == 0 || (state & writingBit) != 0)
+        return;
+
+    const double chainPosition = getChainPosition();
+    if (!bankState.compare_exchange_strong(state, (state ^ liveIndexBit) & ~readyBit))
+        return;
+
+    liveBank = (state ^ liveIndexBit) & liveIndexBit;
+    locate(chainPosition);
+}
+
+void StepSequencer::syncTo(double chainStep)
+{
+    const int chainSteps = banks[static_cast<size_t>(liveBank)].getChainSteps();
+    const double target = std::fmod(std::max(0.0, chainStep), static_cast<double>(chainSteps));
+
+    // Only a host jump (a loop or a locate) costs a search.
+    if (std::abs(target - getChainPosition()) > 1.0e-3)
+        locate(target);
+}
+
+void StepSequencer::locate(double chainStep)
+{
+    const auto& bank = banks[static_cast<size_t>(liveBank)];
+    double stepsBefore = 0.0;
+
+    chainStep = std::fmod(std::max(0.0, chainStep), static_cast<double>(bank.getChainSteps()));
+
+    for (chainIndex = 0; chainIndex < bank.chainLength - 1; ++chainIndex)
+    {
+        const auto steps = static_cast<double>(bank.patterns[static_cast<size_t>(bank.chain[static_cast<size_t>(chainIndex)])].numSteps);
+        if (chainStep < stepsBefore + steps)
+            break;
+
+        stepsBefore += steps;
+    }
+
+    const auto& pattern = bank.patterns[static_cast<size_t>(bank.chain[static_cast<size_t>(chainIndex)])];
+    position = std::min(chainStep - stepsBefore, static_cast<double>(pattern.numSteps));
+    cursor = pattern.firstHitFrom(position);
+}
+
+double StepSequencer::getChainPosition() const
+{
+    const auto& bank = banks[static_cast<size_t>(liveBank)];
+    double steps = position;
+
+    for (int i = 0; i < chainIndex; ++i)
+        steps += bank.patterns[static_cast<size_t>(bank.chain[static_cast<size_t>(i)])].numSteps;
+
+    return steps;
+}
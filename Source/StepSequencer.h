@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+
+// Pattern sequencer running on the audio thread.
+//
+// Patterns of up to maxSteps 16th-note steps are played through a chain,
+// either free-running or following the host's beat position. Each pattern
+// keeps its hits sorted by step and playback walks them with a cursor, so a
+// block costs the hits it emits rather than a scan of the pattern.
+//
+// Patterns are edited on the message thread as a complete Bank and handed
+// over with publish(); the audio thread switches to it at its next block.
+class StepSequencer
+{
+public:
+    static constexpr int maxSteps = 64;
+    static constexpr int maxPatterns = 16;
+    static constexpr int maxHitsPerStep = 8;
+    static constexpr int maxChainLength = 16;
+    static constexpr int stepsPerBeat = 4;
+
+    struct Hit
+    {
+        int step = 0;
+        int drum = 0;
+        float velocity = 0.0f;
+    };
+
+    struct Pattern
+    {
+        int numSteps = 16;
+        int numHits = 0;
+        std::array<Hit, maxSteps * maxHitsPerStep> hits {};
+
+        // Sets one drum on one step, or clears it for a velocity of zero.
+        // Hits on the same step keep the order they were added in.
+        bool setHit(int step, int drum, float velocity);
+        void setLength(int steps);
+        void clear();
+
+        // Velocity of one drum on one step, or zero if it has no hit there.
+        float getVelocity(int step, int drum) const;
+
+        // Index of the first hit at or after step.
+        int firstHitFrom(double step) const;
+    };
+
+    struct Bank
+    {
+        std::array<Pattern, maxPatterns> patterns {};
+        std::array<int, maxChainLength> chain {};
+        int chainLength = 1;
+
+        bool setChain(const int* patternIndices, int length);
+        int getChainSteps() const;
+    };
+
+    // Message thread: copies bank into the buffer the audio thread is not
+    // reading and marks it ready.
+    void publish(const Bank& bank);
+
+    // Audio thread.
+    void reset();
+    void start(bool loop);
+    void stop() { playing = false; }
+    bool isPlaying() const { return playing; }
+
+    // Switches to a newly published bank, keeping the current position.
+    void beginBlock();
+
+    // Follows the host: chainStep is the host's position in steps, taken
+    // modulo the chain length. Whether the chain loops is left as start()
+    // set it, so a one-shot still stops at the end of the chain.
+    void syncTo(double chainStep);
+
+    // Calls onHit(sampleOffset, drum, velocity) for each hit starting in the
+    // next numSamples samples. An offset can equal numSamples when a hit
+    // falls between the block's last sample and the next block.
+    template <typename Callback>
+    void process(int numSamples, double samplesPerStep, Callback&& onHit);
+
+private:
+    enum : int
+    {
+        liveIndexBit = 1,
+        readyBit = 2,
+        writingBit = 4
+    };
+
+    void locate(double chainStep);
+    double getChainPosition() const;
+
+    std::array<Bank, 2> banks {};
+    std::atomic<int> bankState { 0 };
+    int liveBank = 0;
+
+    bool playing = false;
+    bool looping = false;
+    int chainIndex = 0;
+    int cursor = 0;
+    double position = 0.0; // Steps into the current pattern.
+};
+
+template <typename Callback>
+void StepSequencer::process(int numSamples, double samplesPerStep, Callback&& onHit)
+{
+    if (!playing || samplesPerStep <= 0.0)
+        return;
+
+    const auto& bank = banks[static_cast<size_t>(liveBank)];
+    double stepsDone = 0.0;
+    double remaining = static_cast<double>(numSamples) / samplesPerStep;
+
+    while (remaining > 0.0)
+    {
+        const auto& pattern = bank.patterns[static_cast<size_t>(bank.chain[static_cast<size_t>(chainIndex)])];
+        const double end = position + remaining;
+        const double limit = std::min(end, static_cast<double>(pattern.numSteps));
+
+        for (; cursor < pattern.numHits && pattern.hits[static_cast<size_t>(cursor)].step < limit; ++cursor)
+        {
+            const auto& hit = pattern.hits[static_cast<size_t>(cursor)];
+            const double offset = (stepsDone + static_cast<double>(hit.step) - position) * samplesPerStep;
+            onHit(static_cast<int>(std::ceil(offset - 1.0e-6)), hit.drum, hit.velocity);
+        }
+
+        if (end < static_cast<double>(pattern.numSteps))
+        {
+            position = end;
+            return;
+        }
+
+        stepsDone += static_cast<double>(pattern.numSteps) - position;
+        remaining = end - static_cast<double>(pattern.numSteps);
+        position = 0.0;
+        cursor = 0;
+
+        if (++chainIndex >= bank.chainLength)
+        {
+            chainIndex = 0;
+
+            if (!looping)
+            {
+                playing = false;
+                return;
+            }
+        }
+    }
+}
@@ -0,0 +1,256 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <juce_dsp/juce_dsp.h>
+
+#include "../Source/DrumDsp.h"
+
+// Cost per sample of the phasor oscillators and the softClip modes against
+// the std::sin / std::tanh code they replace, plus the softClip error bounds
+// quoted in Source/DrumDsp.h. Only the error bounds can fail the run; the
+// timings depend on the machine and are printed for reference, and mean
+// nothing outside a Release build.
+namespace
+{
+constexpr double sampleRate = 48000.0;
+constexpr int spanSamples = 512;
+constexpr int benchSamples = 1 << 20;
+constexpr int repeats = 20;
+constexpr double twoPi = 6.283185307179586;
+
+// Keeps the optimiser from dropping the loops being timed.
+volatile float sink = 0.0f;
+
+template <typename Function>
+double nanosecondsPerSample(Function&& function)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int r = 0; r < repeats; ++r)
+        function();
+
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / (static_cast<double>(repeats) * benchSamples);
+}
+
+// Three fixed partials per voice, as in the hats and toms.
+const std::array<float, 3> fixedIncrements { static_cast<float>(twoPi * 940.0 / sampleRate),
+                                             static_cast<float>(twoPi * 2310.0 / sampleRate),
+                                             static_cast<float>(twoPi * 7340.0 / sampleRate) };
+
+double fixedPartialsWithSin()
+{
+    return nanosecondsPerSample([]
+    {
+        std::array<float, 3> phases {};
+        float sum = 0.0f;
+
+        for (int i = 0; i < benchSamples; ++i)
+        {
+            for (size_t k = 0; k < phases.size(); ++k)
+            {
+                sum += std::sin(phases[k]);
+                phases[k] += fixedIncrements[k];
+            }
+        }
+
+        sink = sink + sum;
+    });
+}
+
+// Per voice: a SIMD run renders one voice per lane.
+template <typename SampleType>
+double fixedPartialsWithPhasors()
+{
+    using L = drumdsp::Lanes<SampleType>;
+
+    return nanosecondsPerSample([]
+    {
+        std::array<drumdsp::Phasor<float>, 3> state {};
+        SampleType sum = 0.0f;
+
+        for (int start = 0; start < benchSamples; start += spanSamples)
+        {
+            drumdsp::PhasorBank<3, SampleType> bank;
+
+            for (size_t lane = 0; lane < L::count; ++lane)
+                bank.setLane(lane, state);
+
+            bank.prepare(fixedIncrements, spanSamples);
+
+            for (int i = 0; i < spanSamples; ++i)
+            {
+                sum += bank.sin(0) + bank.sin(1) + bank.sin(2);
+                bank.advance();
+            }
+
+            bank.getLane(0, state);
+        }
+
+        sink = sink + L::sum(sum);
+    }) / static_cast<double>(L::count);
+}
+
+// Two pitch-swept partials per voice, as in the kick and snare bodies. The
+// increments are precomputed so that only the oscillators are timed.
+std::vector<float> sweptIncrements()
+{
+    std::vector<float> increments(static_cast<size_t>(benchSamples) + 1);
+
+    for (size_t i = 0; i < increments.size(); ++i)
+    {
+        const float sweep = std::exp(-static_cast<float>(i % 4096) / (0.045f * static_cast<float>(sampleRate)));
+        increments[i] = (sweep * 300.0f + 46.0f) * static_cast<float>(twoPi / sampleRate);
+    }
+
+    return increments;
+}
+
+double sweptPartialsWithSin(const std::vector<float>& increments)
+{
+    return nanosecondsPerSample([&increments]
+    {
+        float phaseA = 0.0f, phaseB = 0.0f, sum = 0.0f;
+
+        for (size_t i = 0; i < static_cast<size_t>(benchSamples); ++i)
+        {
+            phaseA += increments[i + 1];
+            phaseB += increments[i + 1] * 1.5f;
+            sum += std::sin(phaseA) + std::sin(phaseB);
+        }
+
+        sink = sink + sum;
+    });
+}
+
+template <typename SampleType>
+double sweptPartialsWithPhasors(const std::vector<float>& increments)
+{
+    using L = drumdsp::Lanes<SampleType>;
+
+    return nanosecondsPerSample([&increments]
+    {
+        drumdsp::Phasor<float> stateA, stateB;
+        SampleType sum = 0.0f;
+
+        for (int start = 0; start < benchSamples; start += spanSamples)
+        {
+            drumdsp::SweptPhasor<SampleType> sweptA, sweptB;
+
+            for (size_t lane = 0; lane < L::count; ++lane)
+            {
+                sweptA.osc.setLane(lane, stateA);
+                sweptB.osc.setLane(lane, stateB);
+            }
+
+            const float startIncrement = increments[static_cast<size_t>(start)];
+            sweptA.prepare(SampleType(startIncrement));
+            sweptB.prepare(SampleType(startIncrement * 1.5f));
+
+            for (int i = start; i < start + spanSamples; ++i)
+            {
+                const float increment = increments[static_cast<size_t>(i) + 1];
+                sum += sweptA.advance(SampleType(increment)) + sweptB.advance(SampleType(increment * 1.5f));
+            }
+
+            stateA = sweptA.osc.getLane(0);
+            stateB = sweptB.osc.getLane(0);
+        }
+
+        sink = sink + L::sum(sum);
+    }) / static_cast<double>(L::count);
+}
+
+void benchPhasors()
+{
+    const auto increments = sweptIncrements();
+    const double fixedSin = fixedPartialsWithSin();
+    const double sweptSin = sweptPartialsWithSin(increments);
+
+    const auto report = [](const char* name, double before, double after)
+    {
+        std::printf("%-40s %6.2f -> %6.2f ns per voice-sample (%.1fx)\n", name, before, after, before / after);
+    };
+
+    report("fixed partials (3 per voice)", fixedSin, fixedPartialsWithPhasors<float>());
+    report("swept partials (2 per voice)", sweptSin, sweptPartialsWithPhasors<float>(increments));
+   #if JUCE_USE_SIMD
+    report("fixed partials (3 per voice), SIMD lanes", fixedSin, fixedPartialsWithPhasors<drumdsp::FloatVec>());
+    report("swept partials (2 per voice), SIMD lanes", sweptSin, sweptPartialsWithPhasors<drumdsp::FloatVec>(increments));
+   #endif
+}
+
+// Worst error against a double-precision tanh, over a dense sweep of [-8, 8]
+// plus a few points deep in saturation.
+template <drumdsp::SoftClipMode mode>
+double softClipError()
+{
+    double maxError = 0.0;
+
+    for (int i = -2000000; i <= 2000000; ++i)
+    {
+        const float x = static_cast<float>(i) * 4.0e-6f;
+        maxError = juce::jmax(maxError, std::abs(static_cast<double>(drumdsp::softClip<mode>(x)) - std::tanh(static_cast<double>(x))));
+    }
+
+    for (const float x : { 5.5f, 8.0f, 30.0f, -30.0f })
+        maxError = juce::jmax(maxError, std::abs(static_cast<double>(drumdsp::softClip<mode>(x)) - std::tanh(static_cast<double>(x))));
+
+    return maxError;
+}
+
+template <drumdsp::SoftClipMode mode>
+bool benchSoftClip(const char* name, const std::vector<float>& input, double limit)
+{
+    std::vector<float> output(input.size());
+
+    const double scalar = nanosecondsPerSample([&input, &output]
+    {
+        for (size_t i = 0; i < input.size(); ++i)
+            output[i] = drumdsp::softClip<mode>(input[i]);
+
+        sink = sink + output[output.size() / 2];
+    });
+
+    const double copy = nanosecondsPerSample([&input, &output]
+    {
+        std::copy(input.begin(), input.end(), output.begin());
+        sink = sink + output[output.size() / 2];
+    });
+
+    const double block = nanosecondsPerSample([&input, &output]
+    {
+        std::copy(input.begin(), input.end(), output.begin());
+        drumdsp::softClipBlock<mode>(output.data(), static_cast<int>(output.size()));
+        sink = sink + output[output.size() / 2];
+    });
+
+    const double maxError = softClipError<mode>();
+    const bool passed = maxError <= limit;
+    std::printf("softClip %-6s max error %.1e (limit %.0e) %s  %6.2f ns/sample, block %5.2f ns/sample\n",
+                name, maxError, limit, passed ? "ok" : "FAILED", scalar, block - copy);
+    return passed;
+}
+} // namespace
+
+int main()
+{
+    benchPhasors();
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> distribution(-8.0f, 8.0f);
+    std::vector<float> input(static_cast<size_t>(benchSamples));
+
+    for (auto& x : input)
+        x = distribution(random);
+
+    bool passed = true;
+    passed &= benchSoftClip<drumdsp::SoftClipMode::exact>("exact", input, 1.0e-6);
+    passed &= benchSoftClip<drumdsp::SoftClipMode::pade>("pade", input, 1.0e-4);
+    passed &= benchSoftClip<drumdsp::SoftClipMode::table>("table", input, 5.0e-5);
+
+    return passed ? 0 : 1;
+}
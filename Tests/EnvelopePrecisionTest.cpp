@@ -0,0 +1,109 @@
+#include <cmath>
+#include <cstdio>
+
+#include <juce_dsp/juce_dsp.h>
+
+#include "../Source/DrumDsp.h"
+
+// Checks the recursive envelopes against their closed forms, re-anchored every
+// 4096 samples from the voice's absolute time the way the voice kernels drive
+// them, over each curve's whole audible tail at 8-192 kHz.
+namespace
+{
+constexpr int spanSamples = 4096;
+constexpr double relativeLimit = 2.0e-4;
+const double sampleRates[] = { 8000.0, 44100.0, 96000.0, 192000.0 };
+
+// Below this the curves are far under the noise floor and float denormals
+// make a relative comparison meaningless.
+constexpr double floorLevel = 1.0e-30;
+
+bool check(const char* name, double maxError)
+{
+    const bool passed = maxError <= relativeLimit;
+    std::printf("%-40s max relative error %.2e (limit %.0e) %s\n", name, maxError, relativeLimit, passed ? "ok" : "FAILED");
+    return passed;
+}
+
+// Drives one envelope span by span for up to maxSeconds and returns its worst
+// relative error against expected(seconds). reset(t, dt) re-anchors it.
+template <typename Envelope, typename Reset, typename Expected>
+double maxRelativeError(Reset reset, Expected expected, double maxSeconds)
+{
+    double maxError = 0.0;
+
+    for (const double sampleRate : sampleRates)
+    {
+        const auto dt = static_cast<float>(1.0 / sampleRate);
+        const int tailSamples = static_cast<int>(maxSeconds * sampleRate);
+        Envelope envelope;
+
+        for (int start = 0; start < tailSamples; start += spanSamples)
+        {
+            // Same start time the kernels compute from the voice's sample index.
+            reset(envelope, static_cast<float>(start) * dt, dt);
+
+            for (int i = start; i < juce::jmin(tailSamples, start + spanSamples); ++i)
+            {
+                const double want = expected(static_cast<double>(i) / sampleRate);
+                const double got = static_cast<double>(envelope.next());
+
+                if (want > floorLevel)
+                    maxError = juce::jmax(maxError, std::abs(got - want) / want);
+            }
+        }
+    }
+
+    return maxError;
+}
+
+double decayError(float tau)
+{
+    return maxRelativeError<drumdsp::DecayEnvelope<float>>(
+        [tau](auto& env, float t, float dt) { env.reset(t, tau, dt); },
+        [tau](double t) { return std::exp(-t / static_cast<double>(tau)); },
+        juce::jmin(4.0, 70.0 * static_cast<double>(tau)));
+}
+
+double attackDecayError(float attack, float tau)
+{
+    return maxRelativeError<drumdsp::AttackDecayEnvelope<float>>(
+        [attack, tau](auto& env, float t, float dt) { env.reset(t, attack, tau, dt); },
+        [attack, tau](double t)
+        {
+            return juce::jlimit(0.0, 1.0, t / static_cast<double>(attack)) * std::exp(-t / static_cast<double>(tau));
+        },
+        juce::jmin(4.0, 70.0 * static_cast<double>(tau)));
+}
+
+double multiBurstError(const std::array<float, 3>& delays, const std::array<float, 3>& taus)
+{
+    return maxRelativeError<drumdsp::MultiBurstEnvelope<float>>(
+        [delays, taus](auto& env, float t, float dt) { env.reset(t, delays, taus, dt); },
+        [delays, taus](double t)
+        {
+            double sum = 0.0;
+
+            for (size_t i = 0; i < delays.size(); ++i)
+                sum += std::exp(-juce::jmax(0.0, t - static_cast<double>(delays[i])) / static_cast<double>(taus[i]));
+
+            return juce::jmin(1.0, sum);
+        },
+        2.0);
+}
+} // namespace
+
+int main()
+{
+    bool passed = true;
+
+    passed &= check("decay, tau 1.9 ms (kick click)", decayError(0.0019f));
+    passed &= check("decay, tau 18 ms (closed hat)", decayError(0.018f));
+    passed &= check("decay, tau 140 ms (kick body)", decayError(0.14f));
+    passed &= check("decay, tau 760 ms (long tail)", decayError(0.76f));
+    passed &= check("attack 2 ms into decay 180 ms (crash)", attackDecayError(0.002f, 0.18f));
+    passed &= check("attack 1.8 ms into decay 760 ms", attackDecayError(0.0018f, 0.76f));
+    passed &= check("clap bursts", multiBurstError({ 0.0f, 0.012f, 0.022f }, { 0.015f, 0.013f, 0.028f }));
+
+    return passed ? 0 : 1;
+}
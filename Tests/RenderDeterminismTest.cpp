@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+// Renders the same MIDI through the plugin the way a host bounce would, and
+// checks that the result depends only on the input: a second pass after the
+// host re-prepares, and a fresh instance, match bit for bit, and a different
+// block size stays within the envelope and oscillator tolerances, since the
+// voices re-anchor their recursions at block edges.
+namespace
+{
+constexpr double sampleRate = 48000.0;
+constexpr double bpm = 172.0;
+constexpr int renderSamples = static_cast<int>(4.0 * sampleRate);
+constexpr float blockSizeLimit = 1.0e-3f;
+
+// A playing transport from the start of the song.
+struct TestPlayHead final : public juce::AudioPlayHead
+{
+    int64_t position = 0;
+
+    juce::Optional<PositionInfo> getPosition() const override
+    {
+        PositionInfo info;
+        info.setBpm(bpm);
+        info.setIsPlaying(true);
+        info.setTimeInSamples(position);
+        info.setPpqPosition(static_cast<double>(position) * bpm / (60.0 * sampleRate));
+        info.setPpqPositionOfLastBarStart(std::floor(*info.getPpqPosition() / 4.0) * 4.0);
+        return info;
+    }
+};
+
+// A busy 16th-note pattern over every drum, with velocities that vary.
+juce::MidiBuffer makeSong()
+{
+    constexpr int notes[] { 36, 38, 42, 46, 49, 51, 39, 37 };
+    const auto stepSamples = static_cast<int>(sampleRate * 60.0 / bpm / 4.0);
+    juce::MidiBuffer song;
+
+    for (int step = 0; step * stepSamples < renderSamples; ++step)
+    {
+        const int time = step * stepSamples;
+        song.addEvent(juce::MidiMessage::noteOn(10, 42, static_cast<juce::uint8>(60 + (step * 13) % 60)), time);
+
+        if (step % 4 == 0)
+            song.addEvent(juce::MidiMessage::noteOn(10, 36, static_cast<juce::uint8>(120)), time);
+        if (step % 8 == 4)
+            song.addEvent(juce::MidiMessage::noteOn(10, 38, static_cast<juce::uint8>(110)), time);
+        if (step % 2 == 1)
+            song.addEvent(juce::MidiMessage::noteOn(10, notes[(step / 2) % 8], static_cast<juce::uint8>(90)), time);
+        if (step % 3 == 0)
+            song.addEvent(juce::MidiMessage::noteOn(10, 46, static_cast<juce::uint8>(70)), time);
+    }
+
+    return song;
+}
+
+// Interleaved stereo output of the main bus.
+std::vector<float> render(juce::AudioProcessor& processor, const juce::MidiBuffer& song, int blockSize)
+{
+    TestPlayHead playHead;
+    processor.setPlayHead(&playHead);
+    processor.setPlayConfigDetails(0, 2, sampleRate, blockSize);
+    processor.prepareToPlay(sampleRate, blockSize);
+
+    juce::AudioBuffer<float> buffer(processor.getTotalNumOutputChannels(), blockSize);
+    std::vector<float> output;
+    output.reserve(static_cast<size_t>(renderSamples) * 2);
+
+    for (int start = 0; start < renderSamples; start += blockSize)
+    {
+        const int numSamples = juce::jmin(blockSize, renderSamples - start);
+        juce::MidiBuffer midi;
+        midi.addEvents(song, start, numSamples, -start);
+
+        juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), numSamples);
+        block.clear();
+        playHead.position = start;
+        processor.processBlock(block, midi);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            output.push_back(block.getSample(0, i));
+            output.push_back(block.getSample(1, i));
+        }
+    }
+
+    processor.releaseResources();
+    processor.setPlayHead(nullptr);
+    return output;
+}
+
+float maxDifference(const std::vector<float>& a, const std::vector<float>& b)
+{
+    float maxDiff = 0.0f;
+
+    for (size_t i = 0; i < a.size(); ++i)
+        maxDiff = juce::jmax(maxDiff, std::abs(a[i] - b[i]));
+
+    return maxDiff;
+}
+
+bool check(const char* name, float maxDiff, float limit)
+{
+    const bool passed = maxDiff <= limit;
+    std::printf("%-40s max difference %.2e (limit %.0e) %s\n", name, static_cast<double>(maxDiff), static_cast<double>(limit),
+                passed ? "ok" : "FAILED");
+    return passed;
+}
+} // namespace
+
+int main()
+{
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const auto song = makeSong();
+
+    std::unique_ptr<juce::AudioProcessor> processor(createPluginFilter());
+    const auto first = render(*processor, song, 512);
+
+    // A host re-render: the same instance, reset and prepared again.
+    processor->reset();
+    const auto again = render(*processor, song, 512);
+
+    const std::unique_ptr<juce::AudioProcessor> fresh(createPluginFilter());
+    const auto freshRender = render(*fresh, song, 512);
+
+    const std::unique_ptr<juce::AudioProcessor> smallBlocks(createPluginFilter());
+    const auto smallBlockRender = render(*smallBlocks, song, 64);
+
+    const auto peak = std::abs(*std::max_element(first.begin(), first.end(), [](float a, float b) { return std::abs(a) < std::abs(b); }));
+    std::printf("%-40s %.2f\n", "peak level", static_cast<double>(peak));
+
+    bool passed = peak > 0.1f;
+    passed &= check("re-render after prepareToPlay", maxDifference(first, again), 0.0f);
+    passed &= check("fresh instance", maxDifference(first, freshRender), 0.0f);
+    passed &= check("64- against 512-sample blocks", maxDifference(first, smallBlockRender), blockSizeLimit);
+
+    return passed ? 0 : 1;
+}